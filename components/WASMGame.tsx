@@ -28,6 +28,46 @@ interface WASMGameProps {
   onBack?: () => void;
 }
 
+// Engine log lines are "<level digit><text>": 0 debug, 1 info, 2 warn, 3 error
+function printEngineLog(log: string) {
+  for (const line of log.split('\n')) {
+    if (!line) continue;
+    const level = line.charCodeAt(0) - 48;
+    const text = line.slice(1);
+    if (level >= 3) console.error(text);
+    else if (level === 2) console.warn(text);
+    else console.log(text);
+  }
+}
+
+// Combat events of the last update_game, 7 words each: type, entity slot,
+// generation (u32), then amount, x, y, z (f32); see engine/include/combat.h
+const COMBAT_EVENT_WORDS = 7;
+const COMBAT_EVENT_HIT = 0;
+const COMBAT_EVENT_KILL = 1;
+const COMBAT_EVENT_PROJECTILE_SPAWN = 2;
+
+function playCombatEvents(wasmModule: any, eventsPtr: number, count: number) {
+  if (!count) return;
+
+  let hits = 0;
+  let kills = 0;
+  let shots = 0;
+  const base = eventsPtr >> 2;
+  for (let i = 0; i < count; i++) {
+    switch (wasmModule.HEAPU32[base + i * COMBAT_EVENT_WORDS]) {
+      case COMBAT_EVENT_HIT: hits++; break;
+      case COMBAT_EVENT_KILL: kills++; break;
+      case COMBAT_EVENT_PROJECTILE_SPAWN: shots++; break;
+    }
+  }
+
+  // One sound per kind per frame, however many events it had
+  if (kills) soundManager.play('collect', 0.6);
+  else if (hits) soundManager.play('hit', 0.5);
+  if (shots) soundManager.play('attack_fire', 0.4);
+}
+
 export default function WASMGame({ onBack }: WASMGameProps): JSX.Element {
   const { address } = useAccount();
   const chainId = useChainId();
@@ -567,6 +607,9 @@ export default function WASMGame({ onBack }: WASMGameProps): JSX.Element {
           get_entity_count: wasmModule.cwrap('get_entity_count', 'number', []),
           load_building_texture: wasmModule.cwrap('load_building_texture', 'number', ['number', 'number', 'number']),
           cleanup_game: wasmModule.cwrap('cleanup_game', null, []),
+          drain_log: wasmModule.cwrap('drain_log', 'string', []),
+          get_combat_events: wasmModule.cwrap('get_combat_events', 'number', []),
+          get_combat_event_count: wasmModule.cwrap('get_combat_event_count', 'number', []),
         };
         wrappedFunctionsRef.current = wrappedFunctions;
 
@@ -578,6 +621,7 @@ export default function WASMGame({ onBack }: WASMGameProps): JSX.Element {
 
         console.log(`🎮 Initializing game with ${width}x${height}`);
         wrappedFunctions.init_game(width, height);
+        printEngineLog(wrappedFunctions.drain_log());
         console.log('✅ Game initialized');
         
         // Building textures disabled for 3D voxel mode
@@ -630,6 +674,13 @@ export default function WASMGame({ onBack }: WASMGameProps): JSX.Element {
 
           // Update game
           wrappedFunctionsRef.current.update_game(time / 1000);
+
+          // Hits, kills and shots of this update, one pointer and count
+          playCombatEvents(
+            moduleRef.current,
+            wrappedFunctionsRef.current.get_combat_events(),
+            wrappedFunctionsRef.current.get_combat_event_count()
+          );
           
           // AI World Discovery - check every 60 frames (~1 second)
           if (frameCount % 60 === 0) {
@@ -657,6 +708,10 @@ export default function WASMGame({ onBack }: WASMGameProps): JSX.Element {
           // Render
           wrappedFunctionsRef.current.render_game();
 
+          // Engine log of this frame, one call (empty in release builds)
+          const engineLog = wrappedFunctionsRef.current.drain_log();
+          if (engineLog) printEngineLog(engineLog);
+
           // Calculate FPS
           frameCount++;
           fpsTime += deltaTime;
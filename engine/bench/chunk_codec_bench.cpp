@@ -0,0 +1,134 @@
+// Memory per chunk and encode/decode time of the cold chunk tier codec.
+//
+// chunk_terrain.h pulls in the WebGL renderer, so columns are built here the
+// way ChunkTerrain::generateChunkVoxels lays them out (same block IDs, biome
+// surface layers and height ranges) from a cheap smooth height function.
+#include "chunk_codec.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+// TerrainBlock values
+enum Block : uint8_t {
+    AIR = 0, SAND = 1, WATER = 2, OBSIDIAN = 3, LAVA = 4, STONE = 5,
+    SNOW = 6, MOUNTAIN_GRASS = 7, GRASS = 8, DIRT = 9
+};
+
+enum Biome { PLAINS, MOUNTAINS, WATER_BIOME, LAVA_BIOME };
+
+// Same dimensions as the game's ChunkTerrain(12, 20, 4)
+static const int CHUNK_SIZE = 12;
+static const int MAX_HEIGHT = 20;
+static const size_t CHUNK_BLOCKS = CHUNK_SIZE * CHUNK_SIZE * MAX_HEIGHT;
+
+static float smooth(float x, float z) {
+    return 0.5f * std::sin(x * 0.11f + 1.3f) * std::cos(z * 0.09f) +
+           0.3f * std::sin(x * 0.37f - z * 0.23f) +
+           0.2f * std::cos(z * 0.71f + x * 0.05f);
+}
+
+static Biome biomeAt(int x, int z) {
+    float climate = smooth(x * 0.05f + 100.0f, z * 0.05f - 40.0f);
+    if (climate < -0.45f) return WATER_BIOME;
+    if (climate > 0.55f) return LAVA_BIOME;
+    if (climate > 0.15f) return MOUNTAINS;
+    return PLAINS;
+}
+
+static void generateChunk(int chunkX, int chunkZ, uint8_t* blocks) {
+    for (int z = 0; z < CHUNK_SIZE; z++) {
+        for (int x = 0; x < CHUNK_SIZE; x++) {
+            int worldX = chunkX * CHUNK_SIZE + x;
+            int worldZ = chunkZ * CHUNK_SIZE + z;
+            Biome biome = biomeAt(worldX, worldZ);
+            float noise = smooth(static_cast<float>(worldX), static_cast<float>(worldZ));
+            
+            float target;
+            switch (biome) {
+                case WATER_BIOME: target = noise * 2.0f + 3.0f; break;
+                case LAVA_BIOME: target = noise * 3.0f + 4.0f; break;
+                case MOUNTAINS: target = std::max(2.0f, noise * 8.0f + 6.0f); break;
+                default: target = noise * 2.0f + 3.0f; break;
+            }
+            int height = std::max(1, std::min(MAX_HEIGHT, static_cast<int>(target)));
+            
+            uint8_t* column = blocks + (z * CHUNK_SIZE + x) * MAX_HEIGHT;
+            for (int y = 0; y < MAX_HEIGHT; y++) {
+                uint8_t block = AIR;
+                if (y < height) {
+                    bool top = y == height - 1;
+                    switch (biome) {
+                        case WATER_BIOME: block = top ? WATER : SAND; break;
+                        case LAVA_BIOME: block = top ? LAVA : OBSIDIAN; break;
+                        case MOUNTAINS:
+                            block = !top ? STONE : (y > 20 ? SNOW : (y <= 10 ? MOUNTAIN_GRASS : STONE));
+                            break;
+                        default:
+                            block = top ? GRASS : (y > height - 3 ? DIRT : STONE);
+                            break;
+                    }
+                }
+                column[y] = block;
+            }
+        }
+    }
+}
+
+static double microsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int side = argc > 1 ? std::atoi(argv[1]) : 64;  // side x side chunks
+    int chunkCount = side * side;
+    
+    std::vector<uint8_t> raw(CHUNK_BLOCKS * chunkCount);
+    for (int i = 0; i < chunkCount; i++) {
+        generateChunk(i % side, i / side, &raw[CHUNK_BLOCKS * i]);
+    }
+    
+    std::vector<std::vector<uint8_t>> encoded(chunkCount);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < chunkCount; i++) {
+        ChunkCodec::encode(&raw[CHUNK_BLOCKS * i], CHUNK_BLOCKS, encoded[i]);
+    }
+    double encodeMicros = microsSince(start);
+    
+    size_t totalBytes = 0, minBytes = CHUNK_BLOCKS * 2, maxBytes = 0;
+    for (const std::vector<uint8_t>& data : encoded) {
+        totalBytes += data.size();
+        minBytes = std::min(minBytes, data.size());
+        maxBytes = std::max(maxBytes, data.size());
+    }
+    
+    // Best of several passes, each decoding every chunk once
+    std::vector<uint8_t> decoded(CHUNK_BLOCKS);
+    double decodeMicros = 1e30;
+    for (int pass = 0; pass < 5; pass++) {
+        start = std::chrono::steady_clock::now();
+        for (int i = 0; i < chunkCount; i++) {
+            if (!ChunkCodec::decode(encoded[i].data(), encoded[i].size(), decoded.data(), CHUNK_BLOCKS)) {
+                std::printf("decode failed for chunk %d\n", i);
+                return 1;
+            }
+        }
+        decodeMicros = std::min(decodeMicros, microsSince(start));
+        
+        if (!std::equal(decoded.begin(), decoded.end(), raw.end() - CHUNK_BLOCKS)) {
+            std::printf("round trip mismatch\n");
+            return 1;
+        }
+    }
+    
+    std::printf("chunks:          %d (%dx%dx%d blocks)\n", chunkCount, CHUNK_SIZE, CHUNK_SIZE, MAX_HEIGHT);
+    std::printf("raw bytes:       %zu per chunk\n", CHUNK_BLOCKS);
+    std::printf("encoded bytes:   %.0f per chunk (min %zu, max %zu, %.1fx smaller)\n",
+                static_cast<double>(totalBytes) / chunkCount, minBytes, maxBytes,
+                static_cast<double>(CHUNK_BLOCKS) * chunkCount / totalBytes);
+    std::printf("encode:          %.2f us per chunk\n", encodeMicros / chunkCount);
+    std::printf("decode:          %.2f us per chunk\n", decodeMicros / chunkCount);
+    return 0;
+}
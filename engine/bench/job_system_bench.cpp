@@ -0,0 +1,76 @@
+// Scheduler overhead, parallelFor scaling and idle cost of the job system.
+#include "job_system.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <thread>
+#include <vector>
+
+static double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Stand-in for noise generation or meshing: a few transcendentals per element
+static void work(std::vector<float>& out, int begin, int end) {
+    for (int i = begin; i < end; i++) {
+        float x = i * 0.001f;
+        out[i] = std::sin(x) * std::cos(x * 1.7f) + std::sqrt(x + 1.0f);
+    }
+}
+
+int main(int argc, char** argv) {
+    int workers = argc > 1 ? std::atoi(argv[1]) : -1;
+    JobSystem jobs(workers);
+    std::printf("threads:         %d\n", jobs.getStats().threads);
+    
+    // Empty jobs through run() and wait(), from the calling thread
+    const int jobCount = 200000;
+    JobCounter counter;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < jobCount; i++) {
+        jobs.run([] {}, &counter);
+    }
+    jobs.wait(counter);
+    std::printf("run + wait:      %.3f us per empty job\n", millisSince(start) * 1000.0 / jobCount);
+    
+    // parallelFor against a plain loop over the same body
+    const int elements = 1 << 22;
+    std::vector<float> out(elements);
+    start = std::chrono::steady_clock::now();
+    work(out, 0, elements);
+    double serialMillis = millisSince(start);
+    std::printf("serial loop:     %.2f ms for %d elements\n", serialMillis, elements);
+    
+    const int grains[] = {256, 4096, 65536};
+    for (int grain : grains) {
+        double best = 1e30;
+        for (int pass = 0; pass < 5; pass++) {
+            start = std::chrono::steady_clock::now();
+            jobs.parallelFor(elements, grain, [&out](int begin, int end) { work(out, begin, end); });
+            best = std::min(best, millisSince(start));
+        }
+        std::printf("parallelFor:     %.2f ms with grain %d (%.1fx)\n", best, grain, serialMillis / best);
+    }
+    
+    // Many small parallelFors, like one per subsystem per frame
+    const int frames = 2000;
+    start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++) {
+        jobs.parallelFor(2000, 64, [&out](int begin, int end) { work(out, begin, end); });
+    }
+    std::printf("small batches:   %.1f us per parallelFor of 2000 elements\n", millisSince(start) * 1000.0 / frames);
+    
+    JobStats stats = jobs.getStats();
+    std::printf("jobs run:        %llu (%llu stolen)\n",
+                static_cast<unsigned long long>(stats.jobsRun), static_cast<unsigned long long>(stats.jobsStolen));
+                
+    // Process CPU time while nothing is queued; sleeping workers cost ~0
+    std::clock_t cpuStart = std::clock();
+    std::this_thread::sleep_for(std::chrono::seconds(1));
+    double idleCpuMillis = 1000.0 * (std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    std::printf("idle:            %.2f ms CPU over 1 s\n", idleCpuMillis);
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Range queries over 10k entities: SpatialHash plus an exact squared-distance
+// test against the linear sqrt scan EntityManager used before, and the cost
+// of keeping the grid current while every entity moves.
+#include "spatial_hash.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+static double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    int entityCount = argc > 1 ? std::atoi(argv[1]) : 10000;
+    const int queryCount = 10000;
+    const float worldHalfSize = 1000.0f;
+    const float queryRange = 3.0f;   // Melee and projectile hit range
+    
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> coord(-worldHalfSize, worldHalfSize);
+    
+    std::vector<float> x(entityCount), z(entityCount);
+    SpatialHash grid;
+    for (int i = 0; i < entityCount; i++) {
+        x[i] = coord(rng);
+        z[i] = coord(rng);
+        grid.insert(i, x[i], z[i]);
+    }
+    
+    std::vector<float> qx(queryCount), qz(queryCount);
+    for (int q = 0; q < queryCount; q++) {
+        qx[q] = coord(rng);
+        qz[q] = coord(rng);
+    }
+    
+    // Linear scan, one sqrt per entity
+    auto start = std::chrono::steady_clock::now();
+    long scanHits = 0;
+    for (int q = 0; q < queryCount; q++) {
+        for (int i = 0; i < entityCount; i++) {
+            float dx = x[i] - qx[q], dz = z[i] - qz[q];
+            if (std::sqrt(dx * dx + dz * dz) <= queryRange) scanHits++;
+        }
+    }
+    double scanMillis = millisSince(start);
+    
+    // Grid broadphase, squared distances
+    std::vector<int> candidates;
+    start = std::chrono::steady_clock::now();
+    long gridHits = 0;
+    float rangeSq = queryRange * queryRange;
+    for (int q = 0; q < queryCount; q++) {
+        candidates.clear();
+        grid.query(qx[q] - queryRange, qz[q] - queryRange, qx[q] + queryRange, qz[q] + queryRange, candidates);
+        for (int i : candidates) {
+            float dx = x[i] - qx[q], dz = z[i] - qz[q];
+            if (dx * dx + dz * dz <= rangeSq) gridHits++;
+        }
+    }
+    double gridMillis = millisSince(start);
+    
+    if (gridHits != scanHits) {
+        std::printf("hit mismatch: grid %ld, scan %ld\n", gridHits, scanHits);
+        return 1;
+    }
+    
+    // One tick of movement for every entity, up to 0.2 units per axis
+    const int ticks = 100;
+    start = std::chrono::steady_clock::now();
+    for (int t = 0; t < ticks; t++) {
+        for (int i = 0; i < entityCount; i++) {
+            x[i] += ((i + t) % 5 - 2) * 0.1f;
+            z[i] += ((i * 3 + t) % 5 - 2) * 0.1f;
+            grid.move(i, x[i], z[i]);
+        }
+    }
+    double moveMillis = millisSince(start) / ticks;
+    
+    std::printf("entities:        %d, %d queries of range %.0f\n", entityCount, queryCount, queryRange);
+    std::printf("linear scan:     %.2f ms (%ld hits)\n", scanMillis, scanHits);
+    std::printf("spatial hash:    %.2f ms (%.0fx faster)\n", gridMillis, scanMillis / gridMillis);
+    std::printf("grid upkeep:     %.3f ms per tick with every entity moving\n", moveMillis);
+    return 0;
+}
@@ -17,8 +17,8 @@ C:\emsdk\upstream\emscripten\em++.bat ^
   -s MODULARIZE=1 ^
   -s EXPORT_NAME=DragonCityEngine ^
   --bind ^
-  -s EXPORTED_FUNCTIONS="['_main','_init_game','_update_game','_render_game','_set_input','_set_dragon_color','_set_attack','_set_weapon','_get_player_health','_get_player_max_health','_get_current_weapon','_get_entity_count','_load_building_texture','_set_village_texture','_cleanup_game']" ^
-  -s EXPORTED_RUNTIME_METHODS="['ccall','cwrap']" ^
+  -s EXPORTED_FUNCTIONS="['_main','_init_game','_update_game','_render_game','_set_input','_set_dragon_color','_set_attack','_set_weapon','_get_player_health','_get_player_max_health','_get_current_weapon','_get_entity_count','_load_building_texture','_set_village_texture','_cleanup_game','_enable_chunk_cache','_get_hot_chunk_count','_get_cold_chunk_count','_get_hot_chunk_bytes','_get_cold_chunk_bytes','_get_chunk_decode_micros','_set_terrain_block','_set_chunk_prefetch','_set_chunk_memory_budget','_get_chunk_resident_bytes','_get_chunk_evictions','_get_ai_full_count','_get_ai_reduced_count','_get_ai_sleeping_count','_get_job_thread_count','_get_jobs_run','_get_jobs_stolen','_get_population_count','_get_population_saved_chunks','_get_flow_field_build_micros','_get_path_portal_count','_get_path_rebuild_micros','_get_projectile_count','_get_projectiles_dropped','_get_combat_events','_get_combat_event_count','_get_combat_events_dropped','_drain_log','_get_log_dropped']" ^
+  -s EXPORTED_RUNTIME_METHODS="['ccall','cwrap','HEAPU32']" ^
   -I include ^
   src/main.cpp ^
   src/renderer.cpp ^
@@ -30,6 +30,16 @@ C:\emsdk\upstream\emscripten\em++.bat ^
   src/combat.cpp ^
   src/entity.cpp ^
   src/blockchain.cpp ^
+  src/region_file.cpp ^
+  src/chunk_codec.cpp ^
+  src/spatial_hash.cpp ^
+  src/job_system.cpp ^
+  src/population.cpp ^
+  src/flow_field.cpp ^
+  src/pathfinder.cpp ^
+  src/projectile_pool.cpp ^
+  src/log.cpp ^
+  src/hit_test.cpp ^
   -o ..\public\wasm\dragon_city.js
 
 if %ERRORLEVEL% NEQ 0 (
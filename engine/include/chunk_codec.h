@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// Run-length codec for chunk voxel arrays. Blocks are stored column-major, so
+// a column is typically a handful of runs (stone, dirt, grass, air...).
+// Encoded form is a sequence of [runLength][blockId] byte pairs.
+namespace ChunkCodec {
+    void encode(const uint8_t* blocks, size_t count, std::vector<uint8_t>& out);
+    bool decode(const uint8_t* data, size_t size, uint8_t* blocks, size_t count);
+}
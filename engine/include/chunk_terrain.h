@@ -1,9 +1,14 @@
 #pragma once
 
 #include "renderer.h"
+#include "region_file.h"
 #include <vector>
 #include <map>
 #include <cmath>
+#include <cstdint>
+#include <string>
+
+class JobSystem;
 
 enum class BiomeType {
     PLAINS,
@@ -12,6 +17,21 @@ enum class BiomeType {
     LAVA
 };
 
+// Block IDs stored in chunk voxel arrays (one byte per block)
+enum class TerrainBlock : uint8_t {
+    AIR,
+    SAND,
+    WATER,
+    OBSIDIAN,
+    LAVA,
+    STONE,
+    SNOW,
+    MOUNTAIN_GRASS,
+    GRASS,
+    DIRT,
+    COUNT
+};
+
 struct ChunkCoord {
     int x, z;
     
@@ -23,12 +43,77 @@ struct ChunkCoord {
 
 struct Chunk {
     ChunkCoord coord;
-    std::vector<Vec3> blockPositions;
+    std::vector<uint8_t> blocks;      // Column-major: (z * chunkSize + x) * maxHeight + y
+    std::vector<uint8_t> heights;     // Solid blocks per column (top block + 1)
+    std::vector<uint8_t> biomes;      // BiomeType per column
+    std::vector<Vec3> blockPositions; // Render list built from blocks
     std::vector<Color> blockColors;
-    BiomeType biome;
+    BiomeType biome;                  // Most common column biome
     bool isGenerated;
+    bool isPersisted;                 // Matches the copy in the region cache
+    bool isModified;                  // Edited since generation, cannot be regenerated
+    bool meshDirty;                   // Queued for rebuilding its render list
+    unsigned int lastAccessFrame;     // Last frame it was rendered or queried
     
-    Chunk() : biome(BiomeType::PLAINS), isGenerated(false) {}
+    Chunk() : biome(BiomeType::PLAINS), isGenerated(false), isPersisted(false),
+              isModified(false), meshDirty(false), lastAccessFrame(0) {}
+};
+
+// Result of a terrain raycast. Block coordinates are from worldToBlock;
+// the normal is the face of the hit block the ray entered through.
+struct TerrainRayHit {
+    bool hit;
+    int blockX, blockY, blockZ;
+    int normalX, normalY, normalZ;
+    float distance;
+    Vec3 point;
+    TerrainBlock block;
+};
+
+// Chunk kept outside the active radius in encoded form ([biome][RLE blocks])
+struct ColdChunk {
+    std::vector<uint8_t> data;
+    bool isPersisted;
+    bool isModified;
+};
+
+// Climate fields sampled on a coarse lattice (every BIOME_CELL blocks) and
+// cached per region of BIOME_REGION_CELLS x BIOME_REGION_CELLS cells
+struct ClimateRegion {
+    std::vector<float> biomeNoise;   // (cells + 1)^2 lattice points, row-major by z
+    std::vector<float> temperature;
+};
+
+// Interpolated climate at one column plus the biomes of the surrounding
+// lattice corners and their bilinear weights (used to blend heights)
+struct ClimateSample {
+    float biomeNoise;
+    float temperature;
+    BiomeType corners[4];
+    float weights[4];
+};
+
+struct ChunkCacheStats {
+    int hotChunks;
+    int coldChunks;
+    size_t hotBytesPerChunk;  // Raw voxel bytes of one active chunk
+    size_t coldBytes;         // Total encoded bytes in the cold tier
+    int coldHits;             // Chunks restored by decompressing
+    double decodeMicros;      // Total time spent decompressing cold chunks
+    size_t residentBytes;     // Active chunks, voxels plus render lists
+    size_t memoryBudget;      // Residency budget for active chunks
+    int evictions;            // Chunks moved out of the active set by the budget
+    int prefetchedChunks;     // Chunks generated ahead of the player's view
+    int pendingChunks;        // Missing chunks still queued for generation
+};
+
+// Notified when a chunk enters or leaves the active set (after it is
+// generated or restored, and just before it is evicted)
+class ChunkListener {
+public:
+    virtual ~ChunkListener() {}
+    virtual void onChunkLoaded(const Chunk& chunk) = 0;
+    virtual void onChunkUnloaded(const Chunk& chunk) = 0;
 };
 
 class ChunkTerrain {
@@ -36,25 +121,149 @@ public:
     ChunkTerrain(int chunkSize = 16, int maxHeight = 32, int renderDistance = 3);
     ~ChunkTerrain();
     
-    void update(const Vec3& playerPos);
+    // velocity is in world units per second; with a velocity or look
+    // direction, chunks the player is heading towards are generated first
+    void update(const Vec3& playerPos, const Vec3& velocity = Vec3(), const Vec3& lookDir = Vec3());
     void render(Renderer& renderer, const Vec3& cameraPos);
     
     float getHeightAt(float x, float z) const;
+    
+    // getHeightAt for count points given as x, z pairs. Chunk lookups are
+    // cached within the batch, so there is about one per chunk touched
+    // rather than one per point.
+    void sampleHeights(const float* xz, float* out, int count) const;
+    int getChunkSize() const { return chunkSize_; }  // In blocks (2 world units each)
+    ChunkCoord worldToChunk(float x, float z) const;
+    
+    // Block b is the cube drawn centred on 2b, so it spans [2b - 1, 2b + 1]
+    // on each axis. Every world-to-block conversion goes through this.
+    static int worldToBlock(float v) { return static_cast<int>(std::floor((v + 1.0f) * 0.5f)); }
     BiomeType getBiomeAt(float x, float z) const;
+    float getTemperatureAt(float x, float z) const;
+    
+    // Persistent chunk cache: evicted chunks are written to region files in
+    // this directory and read back instead of being regenerated
+    void setRegionDirectory(const std::string& directory);
+    void flushRegions();
+    
+    // Prefetch chunks that come into view within lookaheadSeconds, as long as
+    // active chunks stay under memoryBudget bytes
+    void setPrefetch(float lookaheadSeconds, size_t memoryBudget) {
+        prefetchSeconds_ = lookaheadSeconds;
+        prefetchBudgetBytes_ = memoryBudget;
+    }
+    void setGenerationBudget(int chunksPerFrame) { generationBudget_ = chunksPerFrame; }
+    
+    // Active chunks are kept while their memory fits this budget; above it,
+    // the least valuable chunks - far away and not touched recently - move to
+    // the cold tier first. By default nothing stays active past
+    // renderDistance + 2; once a budget is set, chunks may stay out to the
+    // cold distance while it has room.
+    void setMemoryBudget(size_t bytes) {
+        stats_.memoryBudget = bytes;
+        unloadDistance_ = coldDistance_;
+    }
+    
+    // Chunks between the unload radius and this distance stay compressed in memory
+    void setColdDistance(int coldDistance) { coldDistance_ = coldDistance; }
+    const ChunkCacheStats& getCacheStats() const { return stats_; }
+    
+    // Voxel editing in block coordinates (see worldToBlock). Only loaded
+    // chunks can be edited; edits remesh the chunk (and neighbours on a
+    // border) over the next frames within the remesh budget.
+    TerrainBlock getBlock(int x, int y, int z) const;
+    bool setBlock(int x, int y, int z, TerrainBlock block);
+    bool removeBlock(int x, int y, int z) { return setBlock(x, y, z, TerrainBlock::AIR); }
+    void setRemeshBudget(int chunksPerFrame) { remeshBudget_ = chunksPerFrame; }
+    
+    // 3D DDA through the voxel grid: cost grows with ray length, not with the
+    // number of blocks. dir does not need to be normalized. Unloaded chunks
+    // are treated as empty space.
+    bool raycast(const Vec3& origin, const Vec3& dir, float maxDist, TerrainRayHit& hit) const;
+    void raycastBatch(const Vec3* origins, const Vec3* dirs, const float* maxDists, int count, TerrainRayHit* hits) const;
+    
+    void addChunkListener(ChunkListener* listener) { listeners_.push_back(listener); }
+    void removeChunkListener(ChunkListener* listener);
+    
+    // Chunk generation and remeshing are spread over jobs when set (optional)
+    void setJobSystem(JobSystem* jobs) { jobs_ = jobs; }
+    
+    static Color getBlockColor(TerrainBlock block);
+    static bool isOpaque(TerrainBlock block) {
+        return block != TerrainBlock::AIR && block != TerrainBlock::WATER;
+    }
     
 private:
-    void generateChunk(const ChunkCoord& coord);
+    void generateChunks(const std::vector<ChunkCoord>& coords);
+    void generateChunkVoxels(Chunk* chunk) const;
+    void prewarmClimate(const ChunkCoord& coord) const;
+    void buildChunkMesh(Chunk* chunk);
+    void markChunkDirty(const ChunkCoord& coord);
+    void markNeighboursDirty(const ChunkCoord& coord);
+    void processDirtyChunks();
+    Chunk* findChunk(const ChunkCoord& coord) const;
+    bool raycastCached(const Vec3& origin, const Vec3& dir, float maxDist, TerrainRayHit& hit,
+                       const Chunk*& cachedChunk, ChunkCoord& cachedCoord) const;
+    void predictPath(const Vec3& playerPos, const Vec3& velocity);
+    void generateMissingChunks(const ChunkCoord& playerChunk, const Vec3& velocity, const Vec3& lookDir);
     void unloadDistantChunks(const Vec3& playerPos);
-    ChunkCoord worldToChunk(float x, float z) const;
+    void evictChunk(std::map<ChunkCoord, Chunk*>::iterator it);
+    size_t chunkMemoryBytes(const Chunk* chunk) const;
+    float estimateHeight(float x, float z) const;
     bool isChunkInViewRange(const ChunkCoord& chunkCoord, const Vec3& cameraPos, int viewDistance) const;
     
+    int blockIndex(int localX, int localY, int localZ) const {
+        return (localZ * chunkSize_ + localX) * maxHeight_ + localY;
+    }
+    
+    void encodeChunk(const Chunk* chunk, std::vector<uint8_t>& out) const;
+    bool decodeChunk(const std::vector<uint8_t>& data, Chunk* chunk);
+    void computeColumnHeights(Chunk* chunk);
+    
+    bool loadChunkFromColdTier(Chunk* chunk);
+    void moveChunkToColdTier(Chunk* chunk);
+    void unloadDistantColdChunks(const ChunkCoord& playerChunk);
+    
+    bool loadChunkFromRegion(Chunk* chunk);
+    void saveChunkToRegion(Chunk* chunk);
+    void saveColdChunkToRegion(const ChunkCoord& coord, ColdChunk& cold);
+    
+    static const int BIOME_CELL = 8;
+    static const int BIOME_REGION_CELLS = 8;
+    
+    const ClimateRegion& getClimateRegion(int regionX, int regionZ) const;
+    void sampleClimate(int blockX, int blockZ, ClimateSample& out) const;
+    void unloadDistantClimate(const ChunkCoord& playerChunk);
+    void computeColumnBiomes(Chunk* chunk);
+    static BiomeType classifyBiome(float biomeNoise, float temperature);
+    float biomeHeight(BiomeType biome, int worldX, int worldZ) const;
+    
     float noise2D(float x, float z) const;
     float fbmNoise(float x, float z, int octaves) const;
     
     int chunkSize_;
     int maxHeight_;
     int renderDistance_;
+    int viewDistance_;
+    int unloadDistance_;    // Active chunks past this ring always go cold
+    int coldDistance_;
+    unsigned int frame_;
     
     std::map<ChunkCoord, Chunk*> chunks_;
+    std::map<ChunkCoord, ColdChunk> coldChunks_;
+    mutable std::map<ChunkCoord, ClimateRegion> climateRegions_;
+    std::vector<ChunkCoord> dirtyChunks_;
+    int remeshBudget_;
+    
+    // Predicted chunk positions over the lookahead window, with arrival time
+    std::vector<std::pair<ChunkCoord, float>> predictedPath_;
+    float prefetchSeconds_;
+    size_t prefetchBudgetBytes_;
+    int generationBudget_;
+    ChunkCacheStats stats_;
     ChunkCoord lastPlayerChunk_;
+    
+    RegionStore* regionStore_;
+    JobSystem* jobs_;
+    std::vector<ChunkListener*> listeners_;
 };
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "renderer.h"
+#include <cstdint>
+#include <vector>
 
 // Weapon types
 enum class WeaponType {
@@ -44,34 +46,51 @@ public:
     float getAttackRange() const;
     bool isRangedWeapon() const;
     
+    static Attack getWeaponStats(WeaponType weapon);
+    
 private:
     float health_;
     float maxHealth_;
     WeaponType currentWeapon_;
     float attackCooldown_;
     float lastAttackTime_;
-    
-    Attack getWeaponStats(WeaponType weapon) const;
 };
 
-// Projectile for ranged attacks
-class Projectile {
+// Combat events of one tick, for UI effects and sound on the JS side
+enum class CombatEventType : uint32_t {
+    HIT,                // Entity damaged (melee or projectile)
+    KILL,               // Entity health reached 0
+    PROJECTILE_SPAWN    // Player fired a projectile
+};
+
+// Read from JS as 7 32-bit words per event: type, entity slot, entity
+// generation (u32), then amount, x, y, z (f32)
+struct CombatEvent {
+    uint32_t type;          // CombatEventType
+    uint32_t entity;        // Handle slot of the entity (slot 0 is a valid entity)
+    uint32_t generation;    // Handle generation; 0 means the event has no entity
+    float amount;           // Damage dealt
+    float x, y, z;          // Where it happened
+};
+
+// Fixed-size ring of combat events, cleared every tick. When a tick has
+// more events than fit, the oldest are overwritten (and counted).
+class CombatEventBuffer {
 public:
-    Projectile(const Vec3& pos, const Vec3& dir, float damage, float speed);
+    explicit CombatEventBuffer(int capacity = 256);
     
-    void update(float deltaTime);
-    void render(class Renderer& renderer);
+    void clear() { head_ = 0; count_ = 0; }
+    void push(CombatEventType type, uint32_t entity, uint32_t generation, float amount, const Vec3& position);
     
-    Vec3 getPosition() const { return position_; }
-    float getDamage() const { return damage_; }
-    bool isActive() const { return active_; }
-    void deactivate() { active_ = false; }
+    // The events oldest first as one array (the ring is rotated in place
+    // if it wrapped)
+    const CombatEvent* data();
+    int getCount() const { return count_; }
+    int getDropped() const { return dropped_; }  // Overwritten since start
     
 private:
-    Vec3 position_;
-    Vec3 direction_;
-    Vec3 velocity_;
-    float damage_;
-    float lifetime_;
-    bool active_;
+    std::vector<CombatEvent> events_;
+    int head_;     // Next slot written
+    int count_;
+    int dropped_;
 };
@@ -2,7 +2,14 @@
 
 #include "renderer.h"
 #include "combat.h"
+#include "spatial_hash.h"
 #include <vector>
+#include <cstdint>
+
+class ChunkTerrain;
+class JobSystem;
+class FlowField;
+class HierarchicalPathfinder;
 
 // Entity types
 enum class EntityType {
@@ -22,66 +29,65 @@ enum class AIState {
     FLEE
 };
 
-// Base Entity class
-class Entity {
-public:
-    Entity(EntityType type, const Vec3& position);
-    virtual ~Entity() = default;
-    
-    // Core properties
-    Vec3 getPosition() const { return position_; }
-    void setPosition(const Vec3& pos) { position_ = pos; }
-    EntityType getType() const { return type_; }
-    bool isAlive() const { return combat_.getHealth() > 0; }
-    
-    // Combat
-    CombatComponent& getCombat() { return combat_; }
-    const CombatComponent& getCombat() const { return combat_; }
-    
-    // Update & Render
-    virtual void update(float deltaTime, const Vec3& playerPos);
-    virtual void render(class Renderer& renderer);
-    
-    // AI
-    AIState getAIState() const { return aiState_; }
-    void setAIState(AIState state) { aiState_ = state; }
-    
-protected:
-    EntityType type_;
-    Vec3 position_;
-    Vec3 velocity_;
-    CombatComponent combat_;
-    AIState aiState_;
-    float aiTimer_;
-    Vec3 patrolTarget_;
-    
-    // AI behaviors
-    void updateAI(float deltaTime, const Vec3& playerPos);
-    void moveTowards(const Vec3& target, float speed, float deltaTime);
-    float distanceTo(const Vec3& target) const;
+// AI level of detail, picked each tick from the distance to the player
+enum class AILod : uint8_t {
+    FULL,       // AI every tick
+    REDUCED,    // AI every few ticks with the accumulated time
+    SLEEPING    // No AI or movement; elapsed time is caught up on waking
 };
 
-// Dragon Entity (can be friendly or enemy)
-class DragonEntity : public Entity {
-public:
-    DragonEntity(EntityType type, const Vec3& position, const Color& color);
+struct AILodStats {
+    int full;
+    int reduced;
+    int sleeping;
+};
+
+// Stable reference to an entity. Slots are reused after an entity is
+// removed; the generation tells a stale handle apart from the slot's new owner.
+struct EntityHandle {
+    uint32_t slot;
+    uint32_t generation;  // 0 never refers to an entity
     
-    void render(Renderer& renderer) override;
-    void setColor(const Color& color) { color_ = color; }
+    EntityHandle() : slot(0), generation(0) {}
+    EntityHandle(uint32_t s, uint32_t g) : slot(s), generation(g) {}
     
-private:
-    Color color_;
-    float wingFlap_;
+    bool isNull() const { return generation == 0; }
+    bool operator==(const EntityHandle& other) const { return slot == other.slot && generation == other.generation; }
+    bool operator!=(const EntityHandle& other) const { return !(*this == other); }
 };
 
-// Goblin Enemy
-class GoblinEntity : public Entity {
-public:
-    GoblinEntity(const Vec3& position);
-    void render(Renderer& renderer) override;
-    
-private:
-    float animTimer_;
+// Component arrays (structure of arrays). Entity i owns element i of every
+// array; removing an entity moves the last one into its place.
+struct TransformComponents {
+    std::vector<float> x, y, z;
+};
+
+struct VelocityComponents {
+    std::vector<float> x, y, z;
+};
+
+struct CombatComponents {
+    std::vector<float> health;
+    std::vector<float> maxHealth;
+    std::vector<float> cooldown;     // Seconds until the next attack
+    std::vector<WeaponType> weapon;
+};
+
+struct AIComponents {
+    std::vector<AIState> state;
+    std::vector<float> timer;
+    std::vector<float> patrolX, patrolZ;  // Current patrol waypoint
+    std::vector<std::vector<Vec3>> path;  // Patrol route, empty without a pathfinder
+    std::vector<int> pathStep;        // Index of the current waypoint in path
+    std::vector<uint8_t> playerVisible;
+    std::vector<AILod> lod;
+    std::vector<float> pendingTime;  // Time not yet simulated (reduced/sleeping)
+    std::vector<uint32_t> rng;       // Per-entity random state, so AI can run on any thread
+};
+
+struct RenderComponents {
+    std::vector<Color> color;
+    std::vector<float> animTimer;    // Wing flap phase for dragons
 };
 
 // Entity Manager
@@ -90,23 +96,137 @@ public:
     EntityManager();
     ~EntityManager();
     
-    // Entity management
-    void addDragon(EntityType type, const Vec3& position, const Color& color);
-    void addGoblin(const Vec3& position);
+    // Terrain used for line-of-sight checks and ground following (optional,
+    // without it entities stand on the plane y = 1)
+    void setTerrain(const ChunkTerrain* terrain) { terrain_ = terrain; }
+    
+    // AI and integration are spread over jobs when set (optional)
+    void setJobSystem(JobSystem* jobs) { jobs_ = jobs; }
+    
+    // Chasing enemies follow this field towards the player when set (optional,
+    // otherwise they steer straight at the player)
+    void setFlowField(const FlowField* field) { flowField_ = field; }
+    
+    // Patrols pick longer routes around slopes and lava when set (optional,
+    // otherwise they walk straight at a nearby point)
+    void setPathfinder(const HierarchicalPathfinder* pathfinder) { pathfinder_ = pathfinder; }
+    
+    // Entities within fullDistance of the player run AI every tick, those
+    // within activeDistance (normally the chunk load radius) every
+    // reducedInterval ticks, and the rest sleep
+    void setAILod(float fullDistance, float activeDistance, int reducedInterval) {
+        aiFullDistance_ = fullDistance;
+        aiActiveDistance_ = activeDistance;
+        aiReducedInterval_ = reducedInterval > 0 ? reducedInterval : 1;
+    }
+    const AILodStats& getAILodStats() const { return aiLodStats_; }
+    
+    // Entity management, returns a handle to the new entity. Dead entities
+    // are compacted once per update() in a single pass.
+    EntityHandle addDragon(EntityType type, const Vec3& position, const Color& color);
+    EntityHandle addGoblin(const Vec3& position);
     void removeDeadEntities();
+    bool despawnEntity(EntityHandle handle);  // Removes at once; false if stale
+    
+    // Handles stay safe to hold across frames; once the entity is removed
+    // they no longer resolve (indexOf returns -1)
+    bool isValid(EntityHandle handle) const { return indexOf(handle) >= 0; }
+    int indexOf(EntityHandle handle) const {
+        if (handle.slot >= slotGeneration_.size() || slotGeneration_[handle.slot] != handle.generation) return -1;
+        return slotIndex_[handle.slot];
+    }
+    EntityHandle getHandle(int index) const { return EntityHandle(slots_[index], slotGeneration_[slots_[index]]); }
     
     // Update & Render
     void update(float deltaTime, const Vec3& playerPos);
     void render(Renderer& renderer);
     
-    // Collision/Attack
-    Entity* getEntityInRange(const Vec3& position, float range, EntityType excludeType);
-    std::vector<Entity*> getEntitiesInRange(const Vec3& position, float range);
+    // Collision/Attack. Queries only visit the spatial grid cells around the
+    // query volume. damageEntity ignores (and returns false for) stale handles;
+    // killed, when given, is set if this hit took the last of the health.
+    EntityHandle getEntityInRange(const Vec3& position, float range, EntityType excludeType) const; // Closest, null if none
+    void getEntitiesInRange(const Vec3& position, float range, std::vector<EntityHandle>& out) const;
+    void getEntitiesInBox(const Vec3& minCorner, const Vec3& maxCorner, std::vector<EntityHandle>& out) const;
     
-    // Queries
-    int getEntityCount() const { return entities_.size(); }
-    Entity* getEntity(int index);
+    // Area attacks (staff splash, breath). Candidates from the grid cells
+    // under the shape's bounds go through one batched hit-mask kernel
+    // (hit_test.h); getEntitiesInRange is the sphere case. halfAngle in
+    // radians, at most pi / 2.
+    void getEntitiesInCone(const Vec3& apex, const Vec3& axis, float range, float halfAngle,
+                           std::vector<EntityHandle>& out) const;
+    void getEntitiesInCapsule(const Vec3& a, const Vec3& b, float radius, std::vector<EntityHandle>& out) const;
+    bool damageEntity(EntityHandle handle, float amount, bool* killed = nullptr);
+    bool setHealth(EntityHandle handle, float health);
+    
+    // Queries by dense index (0 .. getEntityCount() - 1). Indices change when
+    // dead entities are compacted; keep a handle to refer to an entity later.
+    int getEntityCount() const { return static_cast<int>(types_.size()); }
+    EntityType getType(int index) const { return types_[index]; }
+    Vec3 getPosition(int index) const { return Vec3(transform_.x[index], transform_.y[index], transform_.z[index]); }
+    float getHealth(int index) const { return combat_.health[index]; }
+    bool isAlive(int index) const { return combat_.health[index] > 0; }
+    AIState getAIState(int index) const { return ai_.state[index]; }
     
 private:
-    std::vector<Entity*> entities_;
+    EntityHandle addEntity(EntityType type, const Vec3& position, float maxHealth, WeaponType weapon, const Color& color);
+    void removeEntity(int index);
+    
+    // Systems, each a linear pass over the component arrays
+    void updateVisibility(const Vec3& playerPos);
+    void updateCooldowns(float deltaTime);
+    void updateAI(float deltaTime, const Vec3& playerPos);
+    void runAI(int index, float deltaTime, const Vec3& playerPos);
+    void wakeEntity(int index);
+    void integrate(float deltaTime);
+    void snapToGround();
+    
+    void moveTowards(int index, float targetX, float targetZ, float speed);
+    bool advancePatrol(int index);
+    void renderDragon(Renderer& renderer, int index);
+    void renderGoblin(Renderer& renderer, int index);
+    bool hasLineOfSight(const Vec3& from, const Vec3& to) const;
+    
+    // Living entities in the grid cells over [min, max] (XZ), with their
+    // positions copied out for the hit-mask kernels
+    int gatherCandidates(float minX, float minZ, float maxX, float maxZ) const;
+    void collectHits(int count, std::vector<EntityHandle>& out) const;
+    
+    std::vector<EntityType> types_;
+    std::vector<uint32_t> slots_;  // Handle slot of each entity
+    TransformComponents transform_;
+    VelocityComponents velocity_;
+    CombatComponents combat_;
+    AIComponents ai_;
+    RenderComponents render_;
+    
+    float aiFullDistance_;
+    float aiActiveDistance_;
+    int aiReducedInterval_;
+    AILodStats aiLodStats_;
+    unsigned int frame_;
+    uint32_t spawnCount_;
+    
+    // Entity (x, z) pairs and results of the batched ground height query
+    std::vector<float> groundQuery_;
+    std::vector<float> groundHeights_;
+    
+    // Entities due for AI this tick and the time each one simulates
+    std::vector<int> aiDue_;
+    std::vector<float> aiDueTime_;
+    
+    // Handle slot pool: generation and dense index per slot (-1 when free)
+    std::vector<uint32_t> slotGeneration_;
+    std::vector<int> slotIndex_;
+    std::vector<uint32_t> freeSlots_;
+    
+    // Broadphase over entity indices, moved along in integrate()
+    SpatialHash grid_;
+    mutable std::vector<int> candidates_;
+    mutable std::vector<float> candidateX_, candidateY_, candidateZ_;
+    mutable std::vector<uint8_t> hitMask_;
+    
+    const ChunkTerrain* terrain_;
+    JobSystem* jobs_;
+    const FlowField* flowField_;
+    const HierarchicalPathfinder* pathfinder_;
 };
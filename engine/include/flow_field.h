@@ -0,0 +1,47 @@
+#pragma once
+
+#include "renderer.h"
+#include <cstdint>
+#include <vector>
+
+class ChunkTerrain;
+
+// Shortest-path field towards one target (the player) over the terrain
+// blocks around it. Built with Dijkstra from the target outwards; every
+// cell then points at its cheapest neighbour, so any number of chasers can
+// look up their next step in O(1). Steep steps cost more (climbing more
+// than dropping), water is slow and lava is avoided.
+class FlowField {
+public:
+    explicit FlowField(int radius = 32);
+    
+    // Rebuilds when the target enters another block (or after invalidate());
+    // returns true if it rebuilt
+    bool update(const ChunkTerrain& terrain, const Vec3& target);
+    void invalidate() { valid_ = false; }
+    
+    // Unit direction to walk from (x, z). False outside the field, on
+    // unreachable cells and in the target's own cell (steer straight there).
+    bool sample(float x, float z, float& dirX, float& dirZ) const;
+    
+    int getBuildCount() const { return buildCount_; }
+    double getBuildMicros() const { return buildMicros_; }
+    
+private:
+    void build(const ChunkTerrain& terrain);
+    
+    int radius_;
+    int size_;                   // Cells per side (2 * radius + 1)
+    int originX_, originZ_;      // Block coordinates of cell (0, 0)
+    int targetX_, targetZ_;      // Target block
+    bool valid_;
+    
+    std::vector<float> heights_;
+    std::vector<float> costs_;   // Terrain cost multiplier, < 0 = blocked
+    std::vector<float> dist_;
+    std::vector<int8_t> next_;   // Neighbour index towards the target, -1 none
+    std::vector<float> query_;   // Cell centres for the batched height query
+    
+    int buildCount_;
+    double buildMicros_;
+};
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "renderer.h"
+#include <cstdint>
+
+// Batched overlap tests of many points (structure-of-arrays positions)
+// against one shape, four points per step with wasm simd128 or SSE2 and a
+// scalar fallback otherwise. Each writes mask[i] = 1 for points inside the
+// shape (boundary included) and 0 otherwise, and returns the hit count.
+// Pair them with a broadphase that gathers the candidates first.
+
+int sphereHitMask(const float* x, const float* y, const float* z, int count,
+                  const Vec3& centre, float radius, uint8_t* mask);
+
+// Cone from apex along unit axis up to range, halfAngle in radians (at
+// most pi / 2)
+int coneHitMask(const float* x, const float* y, const float* z, int count,
+                const Vec3& apex, const Vec3& axis, float range, float halfAngle, uint8_t* mask);
+
+// Points within radius of the segment a-b
+int capsuleHitMask(const float* x, const float* y, const float* z, int count,
+                   const Vec3& a, const Vec3& b, float radius, uint8_t* mask);
+
+// "wasm-simd128", "sse2" or "scalar"
+const char* hitTestBackend();
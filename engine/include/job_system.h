@@ -0,0 +1,95 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Threads are available natively and in Emscripten builds with -pthread;
+// plain wasm builds run every job inline on the calling thread
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define DC_JOB_THREADS 1
+#include <condition_variable>
+#include <thread>
+#else
+#define DC_JOB_THREADS 0
+#endif
+
+// Upper bound for worker threads (Emscripten builds match the pthread pool)
+#ifndef DC_MAX_JOB_WORKERS
+#define DC_MAX_JOB_WORKERS 7
+#endif
+
+// Counts outstanding jobs; JobSystem::wait returns once it reaches zero.
+// Jobs that depend on others wait on their counter.
+struct JobCounter {
+    std::atomic<int> pending;
+    JobCounter() : pending(0) {}
+};
+
+struct JobStats {
+    int threads;           // Workers plus the calling thread
+    uint64_t jobsRun;
+    uint64_t jobsStolen;   // Jobs run by a thread other than the one that queued them
+    uint64_t parallelFors;
+};
+
+// Work-stealing scheduler. Every thread owns a deque: it pushes and pops its
+// own jobs at the back and steals from the front of the others when it runs
+// dry. Threads that wait on a counter run jobs in the meantime.
+class JobSystem {
+public:
+    // workerCount threads besides the caller; -1 uses the hardware
+    // concurrency (capped at DC_MAX_JOB_WORKERS)
+    explicit JobSystem(int workerCount = -1);
+    ~JobSystem();
+    
+    void run(const std::function<void()>& job, JobCounter* counter = nullptr);
+    void wait(JobCounter& counter);
+    
+    // Calls body(begin, end) over [0, count) in ranges of about grainSize
+    // and returns when all of them are done
+    void parallelFor(int count, int grainSize, const std::function<void(int begin, int end)>& body);
+    
+    JobStats getStats() const;
+    
+private:
+    struct Job {
+        std::function<void()> fn;
+        JobCounter* counter;
+        int owner;
+    };
+    
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Job> jobs;
+    };
+    
+    bool runOne(int queueIndex);
+    void workerLoop(int queueIndex);
+    
+    std::vector<std::unique_ptr<WorkerQueue>> queues_;
+    std::atomic<bool> running_;
+    std::atomic<int> queuedJobs_;
+    std::atomic<uint64_t> jobsRun_;
+    std::atomic<uint64_t> jobsStolen_;
+    std::atomic<uint64_t> parallelFors_;
+
+#if DC_JOB_THREADS
+    std::vector<std::thread> threads_;
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+#endif
+};
+
+// parallelFor on jobs when a scheduler is set, inline otherwise
+inline void parallelFor(JobSystem* jobs, int count, int grainSize, const std::function<void(int begin, int end)>& body) {
+    if (jobs) {
+        jobs->parallelFor(count, grainSize, body);
+    } else if (count > 0) {
+        body(0, count);
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+// Levels, lowest first. Messages below DC_LOG_LEVEL are compiled out
+// entirely (arguments are not evaluated).
+#define DC_LOG_LEVEL_DEBUG 0
+#define DC_LOG_LEVEL_INFO 1
+#define DC_LOG_LEVEL_WARN 2
+#define DC_LOG_LEVEL_ERROR 3
+#define DC_LOG_LEVEL_OFF 4
+
+// Release builds (NDEBUG) log nothing unless a level is set explicitly
+#ifndef DC_LOG_LEVEL
+#ifdef NDEBUG
+#define DC_LOG_LEVEL DC_LOG_LEVEL_OFF
+#else
+#define DC_LOG_LEVEL DC_LOG_LEVEL_INFO
+#endif
+#endif
+
+// Formats (printf-style) into a preallocated ring of fixed-size lines;
+// nothing reaches JS until logDrain(). Long messages are truncated, and
+// when the ring is full the oldest lines are overwritten.
+void logWrite(int level, const char* format, ...)
+#if defined(__GNUC__) || defined(__clang__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+// Pending lines as one string, oldest first, each "<level digit><text>\n";
+// empties the ring. Valid until the next call.
+const char* logDrain();
+
+// Lines overwritten before they were drained, since start
+int logDroppedCount();
+
+#if DC_LOG_LEVEL <= DC_LOG_LEVEL_DEBUG
+#define DC_LOG_DEBUG(...) logWrite(DC_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define DC_LOG_DEBUG(...) ((void)0)
+#endif
+
+#if DC_LOG_LEVEL <= DC_LOG_LEVEL_INFO
+#define DC_LOG_INFO(...) logWrite(DC_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define DC_LOG_INFO(...) ((void)0)
+#endif
+
+#if DC_LOG_LEVEL <= DC_LOG_LEVEL_WARN
+#define DC_LOG_WARN(...) logWrite(DC_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define DC_LOG_WARN(...) ((void)0)
+#endif
+
+#if DC_LOG_LEVEL <= DC_LOG_LEVEL_ERROR
+#define DC_LOG_ERROR(...) logWrite(DC_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define DC_LOG_ERROR(...) ((void)0)
+#endif
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "chunk_terrain.h"
+#include <cstdint>
+#include <map>
+#include <vector>
+
+struct PathfinderStats {
+    int chunks;             // Chunks in the abstract graph
+    int portals;            // Portal nodes over all chunks
+    int rebuilds;           // Chunk portal graphs rebuilt since start
+    double rebuildMicros;   // Time of the last load/unload update
+};
+
+// Hierarchical pathfinding (HPA*) over the loaded chunks. Each chunk keeps
+// portals on its borders (one per open stretch shared with a loaded
+// neighbour, two for long stretches) and the cost between every pair of its
+// portals. A query runs A* over portals first and only searches blocks
+// inside the chunks the abstract path passes through.
+//
+// The graph follows chunk streaming: a chunk that loads builds its portals
+// with its loaded neighbours and only those neighbours refresh their portal
+// costs; an unloading chunk removes its portals the same way.
+//
+// Block costs match the chase flow field: climbing costs more than dropping,
+// water is slow, lava is blocked. findPath only reads the graph, so it can
+// run from parallel AI jobs.
+class HierarchicalPathfinder : public ChunkListener {
+public:
+    explicit HierarchicalPathfinder(ChunkTerrain& terrain);
+    ~HierarchicalPathfinder();
+    
+    // Block-centre waypoints from start to goal (start excluded, goal block
+    // last). False if either end is not loaded, blocked, or unreachable.
+    bool findPath(const Vec3& start, const Vec3& goal, std::vector<Vec3>& out) const;
+    
+    const PathfinderStats& getStats() const { return stats_; }
+    
+    void onChunkLoaded(const Chunk& chunk) override;
+    void onChunkUnloaded(const Chunk& chunk) override;
+    
+private:
+    // Sides: 0 = -X, 1 = +X, 2 = -Z, 3 = +Z (opposite side is side ^ 1)
+    struct Portal {
+        int side;
+        int offset;   // Position along the border
+        int cell;     // Local cell index (z * chunkSize + x)
+    };
+    
+    struct ChunkGraph {
+        std::vector<uint8_t> heights;     // Blocks per column
+        std::vector<float> costs;         // Cost multiplier per column, < 0 = blocked
+        std::vector<Portal> portals;
+        std::vector<float> portalCosts;   // portals x portals, row = from
+    };
+    
+    int borderCell(int side, int offset) const;
+    void linkBorder(ChunkGraph& graph, ChunkGraph& neighbour, int side);
+    void rebuildPortalCosts(ChunkGraph& graph);
+    static float stepCost(int fromHeight, int toHeight, float toCost);
+    void localSearch(const ChunkGraph& graph, int startCell, bool reverse,
+                     std::vector<float>& dist, std::vector<int>* parent) const;
+    bool localPath(const ChunkGraph& graph, const ChunkCoord& coord, int fromCell, int toCell,
+                   std::vector<Vec3>& out) const;
+    void updateStats();
+    
+    ChunkTerrain& terrain_;
+    int chunkSize_;
+    std::map<ChunkCoord, ChunkGraph> chunks_;
+    PathfinderStats stats_;
+};
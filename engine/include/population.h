@@ -0,0 +1,79 @@
+#pragma once
+
+#include "chunk_terrain.h"
+#include "entity.h"
+#include <deque>
+#include <map>
+#include <vector>
+
+struct PopulationStats {
+    int live;          // Spawned entities still alive in loaded chunks
+    int savedChunks;   // Unloaded chunks whose survivors are kept
+    int spawned;       // Fresh spawns since start
+    int restored;      // Entities brought back from saved chunks
+    int despawned;     // Entities removed because their chunk unloaded
+};
+
+// Ties enemies to terrain chunks. A chunk that loads for the first time gets
+// a deterministic, biome-dependent set of enemies; when it unloads, the
+// enemies standing in it (wherever they spawned) are saved (type, position,
+// health) and removed from the simulation, and come back if the chunk loads
+// again. The simulated population is therefore bounded by the load window,
+// with caps per chunk and overall on top. Chunks that load while the overall
+// cap is reached are populated or restored later, once unloads or kills make
+// room (kills are noticed by update()).
+class PopulationManager : public ChunkListener {
+public:
+    PopulationManager(EntityManager& entities, ChunkTerrain& terrain, uint32_t seed = 12345);
+    ~PopulationManager();
+    
+    // maxSavedChunks limits the unloaded chunks remembered; the oldest are
+    // dropped (and repopulate fresh) beyond it
+    void setCaps(int perChunk, int total, int maxSavedChunks) {
+        maxPerChunk_ = perChunk;
+        maxTotal_ = total;
+        maxSavedChunks_ = maxSavedChunks;
+    }
+    const PopulationStats& getStats() const { return stats_; }
+    
+    // Per tick: fills chunks still waiting for room. Nothing to do (and no
+    // count taken) while none wait.
+    void update();
+    
+    void onChunkLoaded(const Chunk& chunk) override;
+    void onChunkUnloaded(const Chunk& chunk) override;
+    
+private:
+    struct SavedEntity {
+        EntityType type;
+        float x, y, z;
+        float health;
+    };
+    
+    // Loaded chunk waiting for room under the overall cap
+    struct PendingChunk {
+        ChunkCoord coord;
+        BiomeType biome;
+        bool fresh;                          // First visit: spawn from the seed
+        std::vector<SavedEntity> survivors;  // Otherwise, still to be restored
+    };
+    
+    EntityHandle spawn(EntityType type, BiomeType biome, const Vec3& position);
+    void spawnFresh(const ChunkCoord& coord, BiomeType biome, int room, std::vector<EntityHandle>& out);
+    void populatePending();
+    void rehome();
+    int countLive();
+    
+    EntityManager& entities_;
+    ChunkTerrain& terrain_;
+    uint32_t seed_;
+    int maxPerChunk_;
+    int maxTotal_;
+    int maxSavedChunks_;
+    
+    std::map<ChunkCoord, std::vector<EntityHandle>> live_;  // Every loaded chunk, by where entities stand
+    std::map<ChunkCoord, std::vector<SavedEntity>> saved_;
+    std::deque<ChunkCoord> savedOrder_;  // Oldest saved chunk first
+    std::deque<PendingChunk> pending_;   // Oldest first
+    PopulationStats stats_;
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "renderer.h"
+#include "entity.h"
+#include "chunk_terrain.h"
+#include <cstdint>
+#include <vector>
+
+struct ProjectileStats {
+    int spawned;      // Since start
+    int hits;         // Entity hits since start, splash included
+    int dropped;      // Spawns refused because the pool was full
+};
+
+// Entity struck by a projectile during the last update()
+struct ProjectileHit {
+    EntityHandle target;
+    Vec3 position;    // Projectile centre at impact
+    float damage;
+    bool killed;      // This hit took the last of the target's health
+};
+
+// Fixed-capacity projectile store (structure of arrays). Live projectiles
+// are packed at the front; an expired one is replaced by the last, so
+// nothing is allocated after construction.
+//
+// Each update sweeps every projectile's sphere along this frame's travel:
+// entities near the segment come from the entity spatial grid, terrain
+// from one batched raycast, and the earliest contact along the segment
+// wins. Fast projectiles at low frame rates therefore cannot tunnel.
+class ProjectilePool {
+public:
+    explicit ProjectilePool(int capacity = 256);
+    
+    // False (and counted as dropped) when the pool is full. A projectile
+    // with a splash radius (staff bolts) also deals half its damage to every
+    // other entity within that distance of where it lands.
+    bool spawn(const Vec3& position, const Vec3& direction, float speed, float damage,
+               float splashRadius = 0.0f, float radius = 0.15f,
+               const Color& color = Color(1.0f, 0.8f, 0.2f));
+               
+    // Moves every projectile, damages the entities hit and retires
+    // projectiles that hit something or expired. Hits are appended to hits
+    // when given. terrain is optional.
+    void update(float deltaTime, EntityManager& entities, const ChunkTerrain* terrain,
+                std::vector<ProjectileHit>* hits = nullptr);
+                
+    // All projectiles in one instanced draw
+    void render(Renderer& renderer);
+    
+    void clear() { count_ = 0; }
+    int getCount() const { return count_; }
+    int getCapacity() const { return capacity_; }
+    const ProjectileStats& getStats() const { return stats_; }
+    
+private:
+    void remove(int index);
+    void splash(int index, const Vec3& impact, EntityHandle direct, EntityManager& entities,
+                std::vector<ProjectileHit>* hits);
+    
+    int capacity_;
+    int count_;
+    
+    // Components, capacity_ long
+    std::vector<float> x_, y_, z_;
+    std::vector<float> vx_, vy_, vz_;
+    std::vector<float> damage_;
+    std::vector<float> radius_;
+    std::vector<float> splash_;
+    std::vector<float> lifetime_;
+    std::vector<Color> color_;
+    
+    // Per-update scratch, sized once
+    std::vector<Vec3> rayOrigins_;
+    std::vector<Vec3> rayDirs_;
+    std::vector<float> rayLengths_;
+    std::vector<TerrainRayHit> rayHits_;
+    std::vector<uint8_t> expired_;
+    std::vector<EntityHandle> candidates_;
+    std::vector<EntityHandle> splashTargets_;
+    std::vector<CubeInstance> instances_;
+    
+    ProjectileStats stats_;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// On-disk chunk cache. Each region file groups regionSize x regionSize chunks
+// behind a fixed header offset table; payloads are appended and read back
+// through a memory mapping of the whole file.
+//
+// Layout:
+//   RegionHeader
+//   RegionEntry[regionSize * regionSize]   (offset/length, 0 = not stored)
+//   chunk payloads...
+
+struct RegionHeader {
+    char magic[4];        // "DCRG"
+    uint32_t version;
+    uint32_t regionSize;
+    uint32_t reserved;
+};
+
+struct RegionEntry {
+    uint32_t offset;
+    uint32_t length;
+};
+
+class RegionFile {
+public:
+    RegionFile(const std::string& path, int regionSize);
+    ~RegionFile();
+    
+    bool isOpen() const { return fd_ >= 0; }
+    
+    // Local coordinates are in [0, regionSize)
+    bool read(int localX, int localZ, std::vector<uint8_t>& out);
+    bool write(int localX, int localZ, const uint8_t* data, size_t size);
+    
+private:
+    bool initialize();
+    bool mapFile();
+    void unmapFile();
+    
+    int fd_;
+    int regionSize_;
+    size_t fileSize_;
+    uint8_t* mapped_;
+    size_t mappedSize_;
+    std::vector<RegionEntry> entries_;
+};
+
+// Opens region files on demand for a directory and routes chunk
+// coordinates to the right file and slot.
+class RegionStore {
+public:
+    RegionStore(const std::string& directory, int regionSize = 8, int maxOpenFiles = 8);
+    ~RegionStore();
+    
+    bool loadChunk(int chunkX, int chunkZ, std::vector<uint8_t>& out);
+    bool saveChunk(int chunkX, int chunkZ, const std::vector<uint8_t>& data);
+    
+    void closeAll();
+    
+private:
+    RegionFile* getRegion(int regionX, int regionZ);
+    
+    std::string directory_;
+    int regionSize_;
+    int maxOpenFiles_;
+    std::map<std::pair<int, int>, RegionFile*> regions_;
+};
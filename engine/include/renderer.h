@@ -36,6 +36,13 @@ struct Vertex {
     Color color;
 };
 
+// One cube of an instanced draw: centre, edge length and colour
+struct CubeInstance {
+    Vec3 position;
+    float size;
+    Color color;
+};
+
 struct TexVertex {
     Vec3 position;
     float u, v; // texture coordinates
@@ -59,11 +66,28 @@ public:
     void drawTexturedQuad(const Vec3& position, const Vec3& size, GLuint texture);
     void addTexturedQuadToBatch(const Vec3& position, const Vec3& size, GLuint texture);
     
+    // Nearest-filtered textures for lookup data (tile IDs, palettes).
+    // format is GL_LUMINANCE (1 byte per texel) or GL_RGBA.
+    GLuint createDataTexture(GLenum format, int width, int height, const unsigned char* data);
+    void updateDataTexture(GLuint texture, GLenum format, int width, int height, const unsigned char* data);
+    
+    // Draws tile columns [startColumn, endColumn) and rows [0, mapHeight) as
+    // one quad. tileTexture holds mapWidth x mapHeight tile IDs, with world
+    // column x stored in texture column x % mapWidth; paletteTexture is a
+    // 256 x 1 RGBA colour per ID (alpha 0 = not drawn). Tile (x, y) is
+    // centred on (x * tileSize, y * tileSize) in the plane z = depth.
+    void drawTilemap(GLuint tileTexture, GLuint paletteTexture, int mapWidth, int mapHeight,
+                     int startColumn, int endColumn, float tileSize, float depth);
+                     
     // Batched rendering for performance
     void beginBatch();
     void addCubeToBatch(const Vec3& position, const Vec3& size, const Color& color);
     void endBatch();
     
+    // Draws many small cubes with one upload of the instance list and one
+    // instanced draw; the cube geometry itself stays on the GPU
+    void drawCubeInstances(const CubeInstance* instances, int count);
+    
     void present();
     
     int getWidth() const { return width_; }
@@ -72,18 +96,27 @@ public:
 private:
     void createShaderProgram();
     void createTextureShaderProgram();
+    void createTilemapShaderProgram();
+    void createInstanceShaderProgram();
     GLuint compileShader(GLenum type, const char* source);
     
     int width_;
     int height_;
     GLuint shaderProgram_;
     GLuint textureShaderProgram_;
+    GLuint tilemapShaderProgram_;
+    GLuint instanceShaderProgram_;
     GLuint vao_;
     GLuint vbo_;
     GLuint ebo_;
     GLuint texVao_;
     GLuint texVbo_;
     GLuint texEbo_;
+    GLuint tilemapVbo_;
+    GLuint instanceVao_;
+    GLuint cubeVbo_;        // Unit cube, uploaded once
+    GLuint cubeEbo_;
+    GLuint instanceVbo_;    // CubeInstance list, streamed per draw
     
     GLint viewMatrixLoc_;
     GLint projMatrixLoc_;
@@ -94,6 +127,20 @@ private:
     GLint texModelMatrixLoc_;
     GLint texSamplerLoc_;
     
+    GLint tileViewMatrixLoc_;
+    GLint tileProjMatrixLoc_;
+    GLint tileMapSizeLoc_;
+    GLint tileSizeLoc_;
+    GLint tileIdsLoc_;
+    GLint tilePaletteLoc_;
+    
+    GLint instViewMatrixLoc_;
+    GLint instProjMatrixLoc_;
+    
+    // Last matrices set, for programs other than the main one
+    float viewMatrix_[16];
+    float projMatrix_[16];
+    
     // Batching data
     std::vector<Vertex> batchVertices_;
     std::vector<unsigned int> batchIndices_;
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Uniform grid over the XZ plane for range queries. Each id lives in the
+// cell containing its position; move() only touches the cell lists when an
+// id crosses a cell border, so keeping the grid current is O(1) per entity.
+// Queries return the ids in the overlapped cells; callers do the exact test.
+class SpatialHash {
+public:
+    explicit SpatialHash(float cellSize = 8.0f);
+    
+    void insert(int id, float x, float z);
+    void remove(int id);
+    void move(int id, float x, float z);
+    
+    // Ids are dense indices; when the owner moves its last element into a
+    // freed slot, the grid follows with rename(last, slot)
+    void rename(int oldId, int newId);
+    void clear();
+    
+    // Ids in every cell overlapping [minX, maxX] x [minZ, maxZ] (appended)
+    void query(float minX, float minZ, float maxX, float maxZ, std::vector<int>& out) const;
+    
+    float getCellSize() const { return cellSize_; }
+    int getOccupiedCellCount() const { return static_cast<int>(cells_.size()); }
+    
+private:
+    int toCell(float v) const { return static_cast<int>(std::floor(v * invCellSize_)); }
+    static uint64_t cellKey(int cellX, int cellZ) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cellX)) << 32) | static_cast<uint32_t>(cellZ);
+    }
+    void addToCell(int id, uint64_t key);
+    void removeFromCell(int id);
+    
+    float cellSize_;
+    float invCellSize_;
+    std::unordered_map<uint64_t, std::vector<int>> cells_;
+    std::vector<uint64_t> idCell_;  // Cell key per id
+    std::vector<int> idSlot_;       // Position of the id in its cell list, -1 if absent
+};
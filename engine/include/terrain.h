@@ -2,6 +2,7 @@
 
 #include "renderer.h"
 #include <vector>
+#include <cstdint>
 
 enum class BlockType {
     AIR,
@@ -15,6 +16,14 @@ struct Block {
     Vec3 position;
 };
 
+// Result of sweeping a box through the terrain. time is the fraction of the
+// move (0..1) at first contact; normal is the face of the block that was hit.
+struct SweepResult {
+    bool hit;
+    float time;
+    Vec3 normal;
+};
+
 class VoxelTerrain {
 public:
     VoxelTerrain(int size = 10, int maxHeight = 3);
@@ -26,12 +35,23 @@ public:
     float getHeightAt(float x, float z) const;
     bool isColliding(const Vec3& position, float radius) const;
     
+    // Swept AABB test against only the blocks the moving box can touch
+    SweepResult sweepAABB(const Vec3& center, const Vec3& halfExtents, const Vec3& delta) const;
+    
+    bool isOccupied(int cellX, int cellY, int cellZ) const;
+    
 private:
     float noise(float x, float z) const;
     void addBlock(BlockType type, int x, int y, int z);
     Color getBlockColor(BlockType type) const;
+    int worldToCell(float v) const;
     
     int size_;
     int maxHeight_;
     std::vector<Block> blocks_;
+    
+    // One bit per block: cell (x, y, z) -> ((y * size_) + z) * size_ + x,
+    // with x and z offset by size_ / 2 so the grid starts at 0
+    std::vector<uint64_t> occupancy_;
+    std::vector<int> columnHeights_; // Solid blocks per column (top + 1)
 };
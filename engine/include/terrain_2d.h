@@ -3,6 +3,7 @@
 #include "renderer.h"
 #include "village.h"
 #include <vector>
+#include <cstdint>
 
 enum class TileType {
     AIR,
@@ -12,24 +13,74 @@ enum class TileType {
     LAVA
 };
 
+// Tile IDs stored in the level grid (one byte per tile). Type, colour and
+// collision flags come from the palette entry of the ID.
+enum class TileId : uint8_t {
+    SKY,
+    GRASS,
+    DIRT,
+    STONE,
+    PLATFORM,
+    OBSTACLE,
+    LAVA,
+    COUNT
+};
+
+enum TileFlags : uint8_t {
+    TILE_SOLID = 1,
+    TILE_PLATFORM = 2
+};
+
+// Palette entry
 struct Tile {
     TileType type;
     Color color;
+    uint8_t flags;
 };
 
+// Side-scroller level streamed in fixed-width segments. Segments are
+// generated from the seed and their index, so a recycled segment comes
+// back identical when the player returns to it.
 class Terrain2D {
 public:
-    Terrain2D(int width, int height);
+    static const int SEGMENT_WIDTH = 32;
+    
+    // width is the number of columns kept resident (rounded up to whole
+    // segments); the level itself extends without limit to the right
+    Terrain2D(int width, int height, uint32_t seed = 12345);
     ~Terrain2D();
     
+    // Drops every segment and rebuilds the first screen
     void generate();
+    
+    // Generates the segments under the camera and one segment ahead per
+    // call, recycling the ring slots of segments left behind
+    void update(float cameraX);
     void render(Renderer& renderer, float cameraX);
     
-    bool isSolid(int x, int y) const;
-    bool isPlatform(int x, int y) const;
+    bool isColumnLoaded(int x) const {
+        if (x < 0) return false;
+        int segment = x / SEGMENT_WIDTH;
+        return segments_[segment % segmentCount_] == segment;
+    }
+    
+    bool isSolid(int x, int y) const { return (getTileFlags(x, y) & TILE_SOLID) != 0; }
+    bool isPlatform(int x, int y) const { return (getTileFlags(x, y) & TILE_PLATFORM) != 0; }
     int getGroundHeight(int x) const;
     
-    int getWidth() const { return width_; }
+    // Ground heights of columns startX .. startX + count - 1 (0 outside the level)
+    void getGroundHeights(int startX, int count, int* out) const;
+    
+    // TileFlags of one tile, 0 outside the level or in an unloaded column
+    uint8_t getTileFlags(int x, int y) const {
+        if (static_cast<unsigned>(y) >= static_cast<unsigned>(height_) || !isColumnLoaded(x)) return 0;
+        return tileFlags_[tiles_[y * width_ + x % width_]];
+    }
+    
+    TileId getTile(int x, int y) const;
+    static const Tile& getTileInfo(TileId id);
+    
+    int getWidth() const { return width_; } // Resident columns
     int getHeight() const { return height_; }
     
     Village* getVillage() { return village_; }
@@ -37,14 +88,30 @@ public:
 private:
     int width_;
     int height_;
-    std::vector<std::vector<Tile>> tiles_;
+    int segmentCount_;
+    uint32_t seed_;
+    
+    // Ring buffer of columns: world column x lives in slot x % width_
+    std::vector<uint8_t> tiles_; // Row-major TileIds: y * width + slot
+    uint8_t tileFlags_[static_cast<int>(TileId::COUNT)];
+    std::vector<int> groundHeights_; // Highest solid tile per slot, kept by setTile
+    std::vector<int> segments_;      // Segment held by each ring slot, -1 if empty
+    
+    // Tilemap textures, created on the first render
+    GLuint tileTexture_;
+    GLuint paletteTexture_;
+    bool tileTextureDirty_;
     Village* village_;
+    int villageGroundY_;
     
-    void generateTerrain();
-    void addPlatforms();
-    void addObstacles();
-    void addVillage();
+    void generateSegment(int segment);
+    void uploadTilemap(Renderer& renderer);
+    void generateTerrain(int startX, int endX, uint32_t& rng);
+    void addPlatforms(int startX, int endX, uint32_t& rng);
+    void addObstacles(int startX, int endX, uint32_t& rng);
+    void addVillage(int startX, int endX);
+    int naturalGroundHeight(int x) const;
     
     TileType getTileType(int x, int y) const;
-    void setTile(int x, int y, TileType type, const Color& color);
+    void setTile(int x, int y, TileId id);
 };
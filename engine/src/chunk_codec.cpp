@@ -0,0 +1,36 @@
+#include "chunk_codec.h"
+
+namespace ChunkCodec {
+
+void encode(const uint8_t* blocks, size_t count, std::vector<uint8_t>& out) {
+    size_t i = 0;
+    while (i < count) {
+        uint8_t id = blocks[i];
+        size_t run = 1;
+        while (i + run < count && run < 255 && blocks[i + run] == id) {
+            run++;
+        }
+        out.push_back(static_cast<uint8_t>(run));
+        out.push_back(id);
+        i += run;
+    }
+}
+
+bool decode(const uint8_t* data, size_t size, uint8_t* blocks, size_t count) {
+    if (size % 2 != 0) return false;
+    
+    size_t written = 0;
+    for (size_t i = 0; i < size; i += 2) {
+        size_t run = data[i];
+        uint8_t id = data[i + 1];
+        if (run == 0 || written + run > count) return false;
+        
+        for (size_t r = 0; r < run; r++) {
+            blocks[written++] = id;
+        }
+    }
+    
+    return written == count;
+}
+
+} // namespace ChunkCodec
@@ -1,10 +1,21 @@
 #include "chunk_terrain.h"
+#include "chunk_codec.h"
+#include "job_system.h"
 #include <cmath>
 #include <algorithm>
+#include <chrono>
+
+static int floorDiv(int a, int b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
 
 ChunkTerrain::ChunkTerrain(int chunkSize, int maxHeight, int renderDistance)
-    : chunkSize_(chunkSize), maxHeight_(maxHeight), renderDistance_(renderDistance) {
+    : chunkSize_(chunkSize), maxHeight_(maxHeight), renderDistance_(renderDistance),
+      viewDistance_(2), unloadDistance_(renderDistance + 2), coldDistance_(renderDistance + 6), frame_(0), remeshBudget_(4), prefetchSeconds_(2.0f),
+      prefetchBudgetBytes_(16 * 1024 * 1024), generationBudget_(8), stats_(), regionStore_(nullptr), jobs_(nullptr) {
     lastPlayerChunk_ = {0, 0};
+    stats_.hotBytesPerChunk = static_cast<size_t>(chunkSize_) * chunkSize_ * maxHeight_;
+    stats_.memoryBudget = 16 * 1024 * 1024;
 }
 
 ChunkTerrain::~ChunkTerrain() {
@@ -12,13 +23,15 @@ ChunkTerrain::~ChunkTerrain() {
         delete pair.second;
     }
     chunks_.clear();
+    delete regionStore_;
+}
+
+void ChunkTerrain::removeChunkListener(ChunkListener* listener) {
+    listeners_.erase(std::remove(listeners_.begin(), listeners_.end(), listener), listeners_.end());
 }
 
 ChunkCoord ChunkTerrain::worldToChunk(float x, float z) const {
-    return {
-        static_cast<int>(std::floor(x / (chunkSize_ * 2.0f))),
-        static_cast<int>(std::floor(z / (chunkSize_ * 2.0f)))
-    };
+    return {floorDiv(worldToBlock(x), chunkSize_), floorDiv(worldToBlock(z), chunkSize_)};
 }
 
 float ChunkTerrain::noise2D(float x, float z) const {
@@ -45,123 +58,656 @@ float ChunkTerrain::fbmNoise(float x, float z, int octaves) const {
     return total / maxValue;
 }
 
-BiomeType ChunkTerrain::getBiomeAt(float x, float z) const {
-    float biomeNoise = std::sin(x * 0.01f) * std::cos(z * 0.01f);
-    float temperature = std::sin(x * 0.02f + z * 0.02f);
-    
+BiomeType ChunkTerrain::classifyBiome(float biomeNoise, float temperature) {
     if (biomeNoise < -0.3f) return BiomeType::WATER;
     if (biomeNoise > 0.5f && temperature > 0.3f) return BiomeType::LAVA;
     if (biomeNoise > 0.3f) return BiomeType::MOUNTAINS;
     return BiomeType::PLAINS;
 }
 
-void ChunkTerrain::generateChunk(const ChunkCoord& coord) {
-    Chunk* chunk = new Chunk();
-    chunk->coord = coord;
-    chunk->isGenerated = true;
+const ClimateRegion& ChunkTerrain::getClimateRegion(int regionX, int regionZ) const {
+    ChunkCoord key = {regionX, regionZ};
+    auto it = climateRegions_.find(key);
+    if (it != climateRegions_.end()) return it->second;
+    
+    // Lattice points are in block units, including the far edge of the region
+    ClimateRegion& region = climateRegions_[key];
+    int points = BIOME_REGION_CELLS + 1;
+    region.biomeNoise.resize(points * points);
+    region.temperature.resize(points * points);
+    
+    for (int j = 0; j < points; j++) {
+        for (int i = 0; i < points; i++) {
+            float x = static_cast<float>((regionX * BIOME_REGION_CELLS + i) * BIOME_CELL);
+            float z = static_cast<float>((regionZ * BIOME_REGION_CELLS + j) * BIOME_CELL);
+            region.biomeNoise[j * points + i] = std::sin(x * 0.01f) * std::cos(z * 0.01f);
+            region.temperature[j * points + i] = std::sin(x * 0.02f + z * 0.02f);
+        }
+    }
+    
+    return region;
+}
+
+void ChunkTerrain::sampleClimate(int blockX, int blockZ, ClimateSample& out) const {
+    int cellX = floorDiv(blockX, BIOME_CELL);
+    int cellZ = floorDiv(blockZ, BIOME_CELL);
+    float fx = static_cast<float>(blockX - cellX * BIOME_CELL) / BIOME_CELL;
+    float fz = static_cast<float>(blockZ - cellZ * BIOME_CELL) / BIOME_CELL;
+    
+    int regionX = floorDiv(cellX, BIOME_REGION_CELLS);
+    int regionZ = floorDiv(cellZ, BIOME_REGION_CELLS);
+    const ClimateRegion& region = getClimateRegion(regionX, regionZ);
+    
+    int points = BIOME_REGION_CELLS + 1;
+    int i = cellX - regionX * BIOME_REGION_CELLS;
+    int j = cellZ - regionZ * BIOME_REGION_CELLS;
+    int idx[4] = {j * points + i, j * points + i + 1, (j + 1) * points + i, (j + 1) * points + i + 1};
+    
+    out.weights[0] = (1.0f - fx) * (1.0f - fz);
+    out.weights[1] = fx * (1.0f - fz);
+    out.weights[2] = (1.0f - fx) * fz;
+    out.weights[3] = fx * fz;
+    
+    out.biomeNoise = 0.0f;
+    out.temperature = 0.0f;
+    for (int c = 0; c < 4; c++) {
+        float n = region.biomeNoise[idx[c]];
+        float t = region.temperature[idx[c]];
+        out.biomeNoise += n * out.weights[c];
+        out.temperature += t * out.weights[c];
+        out.corners[c] = classifyBiome(n, t);
+    }
+}
+
+// Biome of a world position, from the loaded chunk's column data when
+// available and from the climate lattice otherwise
+BiomeType ChunkTerrain::getBiomeAt(float x, float z) const {
+    int blockX = worldToBlock(x);
+    int blockZ = worldToBlock(z);
+    
+    ChunkCoord coord = {floorDiv(blockX, chunkSize_), floorDiv(blockZ, chunkSize_)};
+    const Chunk* chunk = findChunk(coord);
+    if (chunk) {
+        int localX = blockX - coord.x * chunkSize_;
+        int localZ = blockZ - coord.z * chunkSize_;
+        return static_cast<BiomeType>(chunk->biomes[localZ * chunkSize_ + localX]);
+    }
     
-    int startX = coord.x * chunkSize_;
-    int startZ = coord.z * chunkSize_;
+    ClimateSample sample;
+    sampleClimate(blockX, blockZ, sample);
+    return classifyBiome(sample.biomeNoise, sample.temperature);
+}
+
+float ChunkTerrain::getTemperatureAt(float x, float z) const {
+    ClimateSample sample;
+    sampleClimate(worldToBlock(x), worldToBlock(z), sample);
+    return sample.temperature;
+}
+
+float ChunkTerrain::biomeHeight(BiomeType biome, int worldX, int worldZ) const {
+    switch (biome) {
+        case BiomeType::WATER:
+            return std::max(1.0f, fbmNoise(worldX, worldZ, 2) * 2.0f + 3.0f);
+        case BiomeType::LAVA:
+            return std::max(1.0f, fbmNoise(worldX, worldZ, 2) * 3.0f + 4.0f);
+        case BiomeType::MOUNTAINS:
+            return std::max(2.0f, fbmNoise(worldX, worldZ, 3) * 8.0f + 6.0f);
+        case BiomeType::PLAINS:
+        default:
+            return std::max(1.0f, fbmNoise(worldX, worldZ, 2) * 2.0f + 3.0f);
+    }
+}
+
+void ChunkTerrain::computeColumnBiomes(Chunk* chunk) {
+    int startX = chunk->coord.x * chunkSize_;
+    int startZ = chunk->coord.z * chunkSize_;
+    int counts[4] = {0, 0, 0, 0};
+    
+    for (int z = 0; z < chunkSize_; z++) {
+        for (int x = 0; x < chunkSize_; x++) {
+            ClimateSample sample;
+            sampleClimate(startX + x, startZ + z, sample);
+            BiomeType biome = classifyBiome(sample.biomeNoise, sample.temperature);
+            chunk->biomes[z * chunkSize_ + x] = static_cast<uint8_t>(biome);
+            counts[static_cast<int>(biome)]++;
+        }
+    }
+    
+    chunk->biome = static_cast<BiomeType>(std::max_element(counts, counts + 4) - counts);
+}
+
+Color ChunkTerrain::getBlockColor(TerrainBlock block) {
+    switch (block) {
+        case TerrainBlock::SAND: return Color(0.6f, 0.5f, 0.4f);
+        case TerrainBlock::WATER: return Color(0.2f, 0.4f, 0.8f, 0.7f);
+        case TerrainBlock::OBSIDIAN: return Color(0.3f, 0.3f, 0.3f);
+        case TerrainBlock::LAVA: return Color(1.0f, 0.3f, 0.0f);
+        case TerrainBlock::STONE: return Color(0.5f, 0.5f, 0.5f);
+        case TerrainBlock::SNOW: return Color(0.9f, 0.9f, 0.95f);
+        case TerrainBlock::MOUNTAIN_GRASS: return Color(0.4f, 0.7f, 0.4f);
+        case TerrainBlock::GRASS: return Color(0.4f, 0.86f, 0.51f);
+        case TerrainBlock::DIRT: return Color(0.57f, 0.39f, 0.27f);
+        default: return Color(1, 1, 1);
+    }
+}
+
+// Loads or generates a batch of chunks. Voxel fill and meshing run as jobs;
+// everything that touches the chunk maps or caches stays on this thread.
+void ChunkTerrain::generateChunks(const std::vector<ChunkCoord>& coords) {
+    std::vector<Chunk*> batch;
+    std::vector<Chunk*> fresh;
+    
+    for (const ChunkCoord& coord : coords) {
+        Chunk* chunk = new Chunk();
+        chunk->coord = coord;
+        chunk->isGenerated = true;
+        chunk->blocks.assign(chunkSize_ * chunkSize_ * maxHeight_, static_cast<uint8_t>(TerrainBlock::AIR));
+        chunk->heights.assign(chunkSize_ * chunkSize_, 0);
+        chunk->biomes.assign(chunkSize_ * chunkSize_, static_cast<uint8_t>(BiomeType::PLAINS));
+        
+        // Previously visited chunks come back from the cold tier or region cache
+        if (!loadChunkFromColdTier(chunk) && !loadChunkFromRegion(chunk)) {
+            prewarmClimate(coord);
+            fresh.push_back(chunk);
+        }
+        batch.push_back(chunk);
+    }
+    
+    parallelFor(jobs_, static_cast<int>(fresh.size()), 1, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            generateChunkVoxels(fresh[i]);
+        }
+    });
+    
+    // New chunks count as dirty until their first mesh, so only neighbours
+    // that were already loaded get queued for a rebuild
+    for (Chunk* chunk : batch) {
+        chunk->meshDirty = true;
+        chunk->lastAccessFrame = frame_;
+        chunks_[chunk->coord] = chunk;
+    }
+    for (Chunk* chunk : batch) {
+        markNeighboursDirty(chunk->coord);
+    }
+    
+    parallelFor(jobs_, static_cast<int>(batch.size()), 1, [&](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            buildChunkMesh(batch[i]);
+        }
+    });
+    
+    for (Chunk* chunk : batch) {
+        for (ChunkListener* listener : listeners_) {
+            listener->onChunkLoaded(*chunk);
+        }
+    }
+}
+
+// Climate regions are cached lazily; fill the ones a chunk needs before its
+// voxels are generated off-thread, where the cache is only read
+void ChunkTerrain::prewarmClimate(const ChunkCoord& coord) const {
+    int minBlockX = coord.x * chunkSize_, maxBlockX = minBlockX + chunkSize_ - 1;
+    int minBlockZ = coord.z * chunkSize_, maxBlockZ = minBlockZ + chunkSize_ - 1;
+    int minRegionX = floorDiv(floorDiv(minBlockX, BIOME_CELL), BIOME_REGION_CELLS);
+    int maxRegionX = floorDiv(floorDiv(maxBlockX, BIOME_CELL), BIOME_REGION_CELLS);
+    int minRegionZ = floorDiv(floorDiv(minBlockZ, BIOME_CELL), BIOME_REGION_CELLS);
+    int maxRegionZ = floorDiv(floorDiv(maxBlockZ, BIOME_CELL), BIOME_REGION_CELLS);
+    
+    for (int rz = minRegionZ; rz <= maxRegionZ; rz++) {
+        for (int rx = minRegionX; rx <= maxRegionX; rx++) {
+            getClimateRegion(rx, rz);
+        }
+    }
+}
+
+// Only writes the chunk itself, safe to run as a job
+void ChunkTerrain::generateChunkVoxels(Chunk* chunk) const {
+    int startX = chunk->coord.x * chunkSize_;
+    int startZ = chunk->coord.z * chunkSize_;
+    int biomeCounts[4] = {0, 0, 0, 0};
     
     for (int x = 0; x < chunkSize_; x++) {
         for (int z = 0; z < chunkSize_; z++) {
             int worldX = startX + x;
             int worldZ = startZ + z;
             
-            BiomeType biome = getBiomeAt(static_cast<float>(worldX), static_cast<float>(worldZ));
-            chunk->biome = biome;
+            // Column biome comes from the interpolated climate; the height is
+            // blended from the lattice corner biomes so borders have no cliffs
+            ClimateSample climate;
+            sampleClimate(worldX, worldZ, climate);
+            BiomeType biome = classifyBiome(climate.biomeNoise, climate.temperature);
+            chunk->biomes[z * chunkSize_ + x] = static_cast<uint8_t>(biome);
+            biomeCounts[static_cast<int>(biome)]++;
+            
+            float blended = 0.0f;
+            for (int c = 0; c < 4; c++) {
+                bool seen = false;
+                for (int p = 0; p < c; p++) {
+                    if (climate.corners[p] == climate.corners[c]) seen = true;
+                }
+                if (seen) continue;
+                
+                float weight = 0.0f;
+                for (int p = c; p < 4; p++) {
+                    if (climate.corners[p] == climate.corners[c]) weight += climate.weights[p];
+                }
+                blended += weight * biomeHeight(climate.corners[c], worldX, worldZ);
+            }
             
-            int height = 0;
-            Color color;
+            int height = std::max(1, std::min(maxHeight_, static_cast<int>(blended)));
+            uint8_t* column = &chunk->blocks[blockIndex(x, 0, z)];
             
             switch (biome) {
                 case BiomeType::WATER:
-                    height = std::max(1, static_cast<int>(fbmNoise(worldX, worldZ, 2) * 2.0f + 3.0f));
                     for (int y = 0; y < height; y++) {
-                        chunk->blockPositions.push_back(Vec3(worldX * 2.0f, y * 2.0f, worldZ * 2.0f));
-                        if (y == height - 1) {
-                            chunk->blockColors.push_back(Color(0.2f, 0.4f, 0.8f, 0.7f)); // Water
-                        } else {
-                            chunk->blockColors.push_back(Color(0.6f, 0.5f, 0.4f)); // Sand
-                        }
+                        column[y] = static_cast<uint8_t>(y == height - 1 ? TerrainBlock::WATER : TerrainBlock::SAND);
                     }
                     break;
                     
                 case BiomeType::LAVA:
-                    height = std::max(1, static_cast<int>(fbmNoise(worldX, worldZ, 2) * 3.0f + 4.0f));
                     for (int y = 0; y < height; y++) {
-                        chunk->blockPositions.push_back(Vec3(worldX * 2.0f, y * 2.0f, worldZ * 2.0f));
-                        if (y == height - 1) {
-                            chunk->blockColors.push_back(Color(1.0f, 0.3f, 0.0f)); // Lava
-                        } else {
-                            chunk->blockColors.push_back(Color(0.3f, 0.3f, 0.3f)); // Obsidian
-                        }
+                        column[y] = static_cast<uint8_t>(y == height - 1 ? TerrainBlock::LAVA : TerrainBlock::OBSIDIAN);
                     }
                     break;
                     
                 case BiomeType::MOUNTAINS:
-                    height = std::max(2, static_cast<int>(fbmNoise(worldX, worldZ, 3) * 8.0f + 6.0f));
-                    height = std::min(height, maxHeight_);
                     for (int y = 0; y < height; y++) {
-                        chunk->blockPositions.push_back(Vec3(worldX * 2.0f, y * 2.0f, worldZ * 2.0f));
+                        TerrainBlock block = TerrainBlock::STONE;
                         if (y == height - 1) {
                             if (y > 20) {
-                                chunk->blockColors.push_back(Color(0.9f, 0.9f, 0.95f)); // Snow
-                            } else if (y > 10) {
-                                chunk->blockColors.push_back(Color(0.5f, 0.5f, 0.5f)); // Stone
-                            } else {
-                                chunk->blockColors.push_back(Color(0.4f, 0.7f, 0.4f)); // Grass
+                                block = TerrainBlock::SNOW;
+                            } else if (y <= 10) {
+                                block = TerrainBlock::MOUNTAIN_GRASS;
                             }
-                        } else {
-                            chunk->blockColors.push_back(Color(0.5f, 0.5f, 0.5f)); // Stone
                         }
+                        column[y] = static_cast<uint8_t>(block);
                     }
                     break;
                     
                 case BiomeType::PLAINS:
                 default:
-                    height = std::max(1, static_cast<int>(fbmNoise(worldX, worldZ, 2) * 2.0f + 3.0f));
                     for (int y = 0; y < height; y++) {
-                        chunk->blockPositions.push_back(Vec3(worldX * 2.0f, y * 2.0f, worldZ * 2.0f));
+                        TerrainBlock block = TerrainBlock::STONE;
                         if (y == height - 1) {
-                            chunk->blockColors.push_back(Color(0.4f, 0.86f, 0.51f)); // Grass
+                            block = TerrainBlock::GRASS;
                         } else if (y > height - 3) {
-                            chunk->blockColors.push_back(Color(0.57f, 0.39f, 0.27f)); // Dirt
-                        } else {
-                            chunk->blockColors.push_back(Color(0.5f, 0.5f, 0.5f)); // Stone
+                            block = TerrainBlock::DIRT;
                         }
+                        column[y] = static_cast<uint8_t>(block);
                     }
                     break;
             }
+            
+            chunk->heights[z * chunkSize_ + x] = static_cast<uint8_t>(height);
         }
     }
     
-    chunks_[coord] = chunk;
+    chunk->biome = static_cast<BiomeType>(std::max_element(biomeCounts, biomeCounts + 4) - biomeCounts);
 }
 
-void ChunkTerrain::update(const Vec3& playerPos) {
-    ChunkCoord playerChunk = worldToChunk(playerPos.x, playerPos.z);
+Chunk* ChunkTerrain::findChunk(const ChunkCoord& coord) const {
+    auto it = chunks_.find(coord);
+    return it != chunks_.end() ? it->second : nullptr;
+}
+
+// Render list only holds blocks with at least one face that can be seen.
+// Neighbour chunks that are not loaded count as open space.
+void ChunkTerrain::buildChunkMesh(Chunk* chunk) {
+    chunk->blockPositions.clear();
+    chunk->blockColors.clear();
+    chunk->meshDirty = false;
+    
+    int startX = chunk->coord.x * chunkSize_;
+    int startZ = chunk->coord.z * chunkSize_;
+    
+    const Chunk* west = findChunk({chunk->coord.x - 1, chunk->coord.z});
+    const Chunk* east = findChunk({chunk->coord.x + 1, chunk->coord.z});
+    const Chunk* south = findChunk({chunk->coord.x, chunk->coord.z - 1});
+    const Chunk* north = findChunk({chunk->coord.x, chunk->coord.z + 1});
+    
+    auto opaqueAt = [&](const Chunk* c, int x, int y, int z) {
+        if (!c) return false;
+        return isOpaque(static_cast<TerrainBlock>(c->blocks[blockIndex(x, y, z)]));
+    };
+    
+    for (int x = 0; x < chunkSize_; x++) {
+        for (int z = 0; z < chunkSize_; z++) {
+            int height = chunk->heights[z * chunkSize_ + x];
+            const uint8_t* column = &chunk->blocks[blockIndex(x, 0, z)];
+            
+            for (int y = 0; y < height; y++) {
+                TerrainBlock block = static_cast<TerrainBlock>(column[y]);
+                if (block == TerrainBlock::AIR) continue;
+                
+                bool hidden = y + 1 < maxHeight_ && isOpaque(static_cast<TerrainBlock>(column[y + 1])) &&
+                    (y == 0 || isOpaque(static_cast<TerrainBlock>(column[y - 1]))) &&
+                    (x > 0 ? opaqueAt(chunk, x - 1, y, z) : opaqueAt(west, chunkSize_ - 1, y, z)) &&
+                    (x < chunkSize_ - 1 ? opaqueAt(chunk, x + 1, y, z) : opaqueAt(east, 0, y, z)) &&
+                    (z > 0 ? opaqueAt(chunk, x, y, z - 1) : opaqueAt(south, x, y, chunkSize_ - 1)) &&
+                    (z < chunkSize_ - 1 ? opaqueAt(chunk, x, y, z + 1) : opaqueAt(north, x, y, 0));
+                if (hidden) continue;
+                
+                chunk->blockPositions.push_back(Vec3((startX + x) * 2.0f, y * 2.0f, (startZ + z) * 2.0f));
+                chunk->blockColors.push_back(getBlockColor(block));
+            }
+        }
+    }
+}
+
+void ChunkTerrain::markChunkDirty(const ChunkCoord& coord) {
+    Chunk* chunk = findChunk(coord);
+    if (!chunk || chunk->meshDirty) return;
+    
+    chunk->meshDirty = true;
+    dirtyChunks_.push_back(coord);
+}
+
+void ChunkTerrain::markNeighboursDirty(const ChunkCoord& coord) {
+    markChunkDirty({coord.x - 1, coord.z});
+    markChunkDirty({coord.x + 1, coord.z});
+    markChunkDirty({coord.x, coord.z - 1});
+    markChunkDirty({coord.x, coord.z + 1});
+}
+
+void ChunkTerrain::processDirtyChunks() {
+    std::vector<Chunk*> rebuild;
+    size_t i = 0;
+    
+    // Oldest edits first; whatever does not fit this frame waits for the next
+    while (i < dirtyChunks_.size() && static_cast<int>(rebuild.size()) < remeshBudget_) {
+        Chunk* chunk = findChunk(dirtyChunks_[i]);
+        if (chunk && chunk->meshDirty) {
+            rebuild.push_back(chunk);
+        }
+        i++;
+    }
+    dirtyChunks_.erase(dirtyChunks_.begin(), dirtyChunks_.begin() + i);
+    
+    // Each job writes only its own chunk's render list
+    parallelFor(jobs_, static_cast<int>(rebuild.size()), 1, [&](int begin, int end) {
+        for (int k = begin; k < end; k++) {
+            buildChunkMesh(rebuild[k]);
+        }
+    });
+}
+
+TerrainBlock ChunkTerrain::getBlock(int x, int y, int z) const {
+    if (y < 0 || y >= maxHeight_) return TerrainBlock::AIR;
+    
+    ChunkCoord coord = {floorDiv(x, chunkSize_), floorDiv(z, chunkSize_)};
+    const Chunk* chunk = findChunk(coord);
+    if (!chunk) return TerrainBlock::AIR;
+    
+    return static_cast<TerrainBlock>(chunk->blocks[blockIndex(x - coord.x * chunkSize_, y, z - coord.z * chunkSize_)]);
+}
+
+bool ChunkTerrain::raycast(const Vec3& origin, const Vec3& dir, float maxDist, TerrainRayHit& hit) const {
+    const Chunk* cachedChunk = nullptr;
+    ChunkCoord cachedCoord = {0, 0};
+    return raycastCached(origin, dir, maxDist, hit, cachedChunk, cachedCoord);
+}
+
+void ChunkTerrain::raycastBatch(const Vec3* origins, const Vec3* dirs, const float* maxDists, int count, TerrainRayHit* hits) const {
+    // Rays from nearby origins mostly walk the same chunks, so the chunk
+    // lookup is carried from one ray to the next
+    const Chunk* cachedChunk = nullptr;
+    ChunkCoord cachedCoord = {0, 0};
+    for (int i = 0; i < count; i++) {
+        raycastCached(origins[i], dirs[i], maxDists[i], hits[i], cachedChunk, cachedCoord);
+    }
+}
+
+bool ChunkTerrain::raycastCached(const Vec3& origin, const Vec3& dir, float maxDist, TerrainRayHit& hit,
+                                 const Chunk*& cachedChunk, ChunkCoord& cachedCoord) const {
+    hit.hit = false;
+    hit.distance = maxDist;
     
-    // Generate chunks around player
-    for (int x = -renderDistance_; x <= renderDistance_; x++) {
-        for (int z = -renderDistance_; z <= renderDistance_; z++) {
-            ChunkCoord coord = {playerChunk.x + x, playerChunk.z + z};
+    float len = dir.length();
+    if (len < 0.000001f) return false;
+    Vec3 d = dir * (1.0f / len);
+    
+    // Block b spans [2b - 1, 2b + 1] on each axis (cubes are centred on 2b)
+    int cell[3] = {worldToBlock(origin.x), worldToBlock(origin.y), worldToBlock(origin.z)};
+    float o[3] = {origin.x, origin.y, origin.z};
+    float dv[3] = {d.x, d.y, d.z};
+    int step[3];
+    float tMax[3];
+    float tDelta[3];
+    
+    for (int a = 0; a < 3; a++) {
+        if (dv[a] > 0.0f) {
+            step[a] = 1;
+            tMax[a] = ((cell[a] + 1) * 2.0f - 1.0f - o[a]) / dv[a];
+            tDelta[a] = 2.0f / dv[a];
+        } else if (dv[a] < 0.0f) {
+            step[a] = -1;
+            tMax[a] = (cell[a] * 2.0f - 1.0f - o[a]) / dv[a];
+            tDelta[a] = -2.0f / dv[a];
+        } else {
+            step[a] = 0;
+            tMax[a] = INFINITY;
+            tDelta[a] = INFINITY;
+        }
+    }
+    
+    float t = 0.0f;
+    int axis = -1;
+    
+    while (t <= maxDist) {
+        // Outside the vertical range of the world there is nothing to hit
+        if (cell[1] < 0 && step[1] <= 0) return false;
+        if (cell[1] >= maxHeight_ && step[1] >= 0) return false;
+        
+        if (cell[1] >= 0 && cell[1] < maxHeight_) {
+            ChunkCoord coord = {floorDiv(cell[0], chunkSize_), floorDiv(cell[2], chunkSize_)};
+            if (!cachedChunk || coord.x != cachedCoord.x || coord.z != cachedCoord.z) {
+                cachedChunk = findChunk(coord);
+                cachedCoord = coord;
+            }
             
-            if (chunks_.find(coord) == chunks_.end()) {
-                generateChunk(coord);
+            if (cachedChunk) {
+                int localX = cell[0] - coord.x * chunkSize_;
+                int localZ = cell[2] - coord.z * chunkSize_;
+                TerrainBlock block = static_cast<TerrainBlock>(cachedChunk->blocks[blockIndex(localX, cell[1], localZ)]);
+                
+                if (block != TerrainBlock::AIR) {
+                    hit.hit = true;
+                    hit.blockX = cell[0];
+                    hit.blockY = cell[1];
+                    hit.blockZ = cell[2];
+                    hit.normalX = axis == 0 ? -step[0] : 0;
+                    hit.normalY = axis == 1 ? -step[1] : 0;
+                    hit.normalZ = axis == 2 ? -step[2] : 0;
+                    hit.distance = t;
+                    hit.point = origin + d * t;
+                    hit.block = block;
+                    return true;
+                }
             }
         }
+        
+        // Advance to the next cell boundary along the closest axis
+        axis = (tMax[0] < tMax[1]) ? (tMax[0] < tMax[2] ? 0 : 2) : (tMax[1] < tMax[2] ? 1 : 2);
+        t = tMax[axis];
+        tMax[axis] += tDelta[axis];
+        cell[axis] += step[axis];
+    }
+    
+    return false;
+}
+
+bool ChunkTerrain::setBlock(int x, int y, int z, TerrainBlock block) {
+    if (y < 0 || y >= maxHeight_) return false;
+    
+    ChunkCoord coord = {floorDiv(x, chunkSize_), floorDiv(z, chunkSize_)};
+    Chunk* chunk = findChunk(coord);
+    if (!chunk) return false;
+    
+    int localX = x - coord.x * chunkSize_;
+    int localZ = z - coord.z * chunkSize_;
+    uint8_t& slot = chunk->blocks[blockIndex(localX, y, localZ)];
+    if (slot == static_cast<uint8_t>(block)) return true;
+    slot = static_cast<uint8_t>(block);
+    
+    chunk->isModified = true;
+    chunk->isPersisted = false;
+    
+    // Keep the column height (used for collision) current without a rescan
+    uint8_t& height = chunk->heights[localZ * chunkSize_ + localX];
+    if (block != TerrainBlock::AIR) {
+        height = std::max<uint8_t>(height, static_cast<uint8_t>(y + 1));
+    } else if (y + 1 == height) {
+        const uint8_t* column = &chunk->blocks[blockIndex(localX, 0, localZ)];
+        int h = y;
+        while (h > 0 && column[h - 1] == static_cast<uint8_t>(TerrainBlock::AIR)) {
+            h--;
+        }
+        height = static_cast<uint8_t>(h);
     }
     
+    markChunkDirty(coord);
+    if (localX == 0) markChunkDirty({coord.x - 1, coord.z});
+    if (localX == chunkSize_ - 1) markChunkDirty({coord.x + 1, coord.z});
+    if (localZ == 0) markChunkDirty({coord.x, coord.z - 1});
+    if (localZ == chunkSize_ - 1) markChunkDirty({coord.x, coord.z + 1});
+    return true;
+}
+
+void ChunkTerrain::update(const Vec3& playerPos, const Vec3& velocity, const Vec3& lookDir) {
+    ChunkCoord playerChunk = worldToChunk(playerPos.x, playerPos.z);
+    frame_++;
+    
+    // Generate chunks around player, and ahead of where the player is going
+    predictPath(playerPos, velocity);
+    generateMissingChunks(playerChunk, velocity, lookDir);
+    
     // Unload distant chunks
     unloadDistantChunks(playerPos);
     
+    // Rebuild render lists for edited chunks within this frame's budget
+    processDirtyChunks();
+    
     lastPlayerChunk_ = playerChunk;
 }
 
+void ChunkTerrain::predictPath(const Vec3& playerPos, const Vec3& velocity) {
+    const int steps = 8;
+    
+    predictedPath_.clear();
+    predictedPath_.push_back({worldToChunk(playerPos.x, playerPos.z), 0.0f});
+    
+    for (int i = 1; i <= steps && prefetchSeconds_ > 0.0f; i++) {
+        float t = prefetchSeconds_ * i / steps;
+        ChunkCoord coord = worldToChunk(playerPos.x + velocity.x * t, playerPos.z + velocity.z * t);
+        
+        const ChunkCoord& last = predictedPath_.back().first;
+        if (coord.x != last.x || coord.z != last.z) {
+            predictedPath_.push_back({coord, t});
+        }
+    }
+}
+
+void ChunkTerrain::generateMissingChunks(const ChunkCoord& playerChunk, const Vec3& velocity, const Vec3& lookDir) {
+    // Heading on the ground plane: movement if moving, otherwise the view
+    float hx = velocity.x, hz = velocity.z;
+    if (hx * hx + hz * hz < 0.01f) {
+        hx = lookDir.x;
+        hz = lookDir.z;
+    }
+    float hlen = std::sqrt(hx * hx + hz * hz);
+    if (hlen > 0.0001f) {
+        hx /= hlen;
+        hz /= hlen;
+    }
+    
+    // Score missing chunks by when they will be needed: arrival time at the
+    // predicted position plus ring distance from it, minus a bonus for being
+    // in front of the player. Lower scores are generated first.
+    std::map<ChunkCoord, float> candidates;
+    for (const auto& step : predictedPath_) {
+        for (int x = -renderDistance_; x <= renderDistance_; x++) {
+            for (int z = -renderDistance_; z <= renderDistance_; z++) {
+                ChunkCoord coord = {step.first.x + x, step.first.z + z};
+                if (chunks_.find(coord) != chunks_.end()) continue;
+                
+                float dx = static_cast<float>(coord.x - playerChunk.x);
+                float dz = static_cast<float>(coord.z - playerChunk.z);
+                float dlen = std::sqrt(dx * dx + dz * dz);
+                float facing = dlen > 0.0f ? (dx * hx + dz * hz) / dlen : 1.0f;
+                
+                float score = step.second * 2.0f + std::max(std::abs(x), std::abs(z)) - facing;
+                auto it = candidates.find(coord);
+                if (it == candidates.end() || score < it->second) {
+                    candidates[coord] = score;
+                }
+            }
+        }
+    }
+    
+    std::vector<std::pair<float, ChunkCoord>> queue;
+    queue.reserve(candidates.size());
+    for (const auto& pair : candidates) {
+        queue.push_back({pair.second, pair.first});
+    }
+    std::sort(queue.begin(), queue.end(), [](const std::pair<float, ChunkCoord>& a, const std::pair<float, ChunkCoord>& b) {
+        return a.first < b.first;
+    });
+    
+    size_t residentBytes = 0;
+    for (const auto& pair : chunks_) {
+        residentBytes += chunkMemoryBytes(pair.second);
+    }
+    size_t bytesPerChunk = chunks_.empty() ? sizeof(Chunk) + chunkSize_ * chunkSize_ * (maxHeight_ + 2)
+                                           : residentBytes / chunks_.size();
+    size_t loadedBytes = residentBytes;
+    
+    // Pick this frame's chunks first (budgets use the average chunk size),
+    // then generate them together so the work can be spread over jobs
+    std::vector<ChunkCoord> batch;
+    int generated = 0;
+    for (const auto& entry : queue) {
+        const ChunkCoord& coord = entry.second;
+        int dist = std::max(std::abs(coord.x - playerChunk.x), std::abs(coord.z - playerChunk.z));
+        
+        // The ring under the player is always generated (collision needs it);
+        // everything else waits for the per-frame budget
+        if (dist > 1 && generated >= generationBudget_) continue;
+        
+        // Prefetched chunks (outside the current view) respect the prefetch
+        // budget; anything beyond the rendered ring respects the memory budget
+        bool prefetch = dist > renderDistance_;
+        if (prefetch && residentBytes + bytesPerChunk > prefetchBudgetBytes_) continue;
+        if (dist > viewDistance_ && residentBytes + bytesPerChunk > stats_.memoryBudget) continue;
+        
+        batch.push_back(coord);
+        residentBytes += bytesPerChunk;
+        generated++;
+        if (prefetch) stats_.prefetchedChunks++;
+    }
+    
+    generateChunks(batch);
+    for (const ChunkCoord& coord : batch) {
+        loadedBytes += chunkMemoryBytes(chunks_[coord]);
+    }
+    
+    stats_.residentBytes = loadedBytes;
+    stats_.pendingChunks = static_cast<int>(queue.size()) - generated;
+}
+
+size_t ChunkTerrain::chunkMemoryBytes(const Chunk* chunk) const {
+    return sizeof(Chunk) + chunk->blocks.capacity() + chunk->heights.capacity() +
+           chunk->biomes.capacity() + chunk->blockPositions.capacity() * sizeof(Vec3) +
+           chunk->blockColors.capacity() * sizeof(Color);
+}
+
 void ChunkTerrain::unloadDistantChunks(const Vec3& playerPos) {
     ChunkCoord playerChunk = worldToChunk(playerPos.x, playerPos.z);
-    int unloadDistance = renderDistance_ + 2;
+    
+    // Chunks past the unload distance always leave the active set. Closer
+    // ones stay while they fit the memory budget and become eviction
+    // candidates (except the rendered ring) when they do not.
+    std::vector<std::pair<float, ChunkCoord>> candidates;
+    size_t residentBytes = 0;
     
     auto it = chunks_.begin();
     while (it != chunks_.end()) {
@@ -169,20 +715,143 @@ void ChunkTerrain::unloadDistantChunks(const Vec3& playerPos) {
         int dz = it->first.z - playerChunk.z;
         int dist = std::max(std::abs(dx), std::abs(dz));
         
-        if (dist > unloadDistance) {
-            delete it->second;
-            it = chunks_.erase(it);
+        // Prefetched chunks along the predicted path count as close
+        for (const auto& step : predictedPath_) {
+            int pdx = it->first.x - step.first.x;
+            int pdz = it->first.z - step.first.z;
+            if (std::max(std::abs(pdx), std::abs(pdz)) <= renderDistance_) {
+                dist = std::min(dist, renderDistance_);
+                break;
+            }
+        }
+        
+        if (dist > unloadDistance_) {
+            auto next = std::next(it);
+            evictChunk(it);
+            it = next;
+            continue;
+        }
+        
+        residentBytes += chunkMemoryBytes(it->second);
+        if (dist > viewDistance_) {
+            // Weighted LRU: one ring of distance ~ one second without access
+            float idleSeconds = (frame_ - it->second->lastAccessFrame) / 60.0f;
+            candidates.push_back({dist + idleSeconds, it->first});
+        }
+        ++it;
+    }
+    
+    if (residentBytes > stats_.memoryBudget) {
+        std::sort(candidates.begin(), candidates.end(), [](const std::pair<float, ChunkCoord>& a, const std::pair<float, ChunkCoord>& b) {
+            return a.first > b.first;
+        });
+        
+        for (const auto& candidate : candidates) {
+            if (residentBytes <= stats_.memoryBudget) break;
+            
+            auto victim = chunks_.find(candidate.second);
+            residentBytes -= chunkMemoryBytes(victim->second);
+            evictChunk(victim);
+            stats_.evictions++;
+        }
+    }
+    
+    unloadDistantColdChunks(playerChunk);
+    unloadDistantClimate(playerChunk);
+    stats_.hotChunks = static_cast<int>(chunks_.size());
+    stats_.residentBytes = residentBytes;
+}
+
+void ChunkTerrain::evictChunk(std::map<ChunkCoord, Chunk*>::iterator it) {
+    for (ChunkListener* listener : listeners_) {
+        listener->onChunkUnloaded(*it->second);
+    }
+    moveChunkToColdTier(it->second);
+    delete it->second;
+    chunks_.erase(it);
+}
+
+void ChunkTerrain::unloadDistantClimate(const ChunkCoord& playerChunk) {
+    // Keep climate regions covering the cold radius (plus one region of slack)
+    int regionBlocks = BIOME_CELL * BIOME_REGION_CELLS;
+    int keepBlocks = (coldDistance_ + 1) * chunkSize_ + regionBlocks;
+    int playerBlockX = playerChunk.x * chunkSize_;
+    int playerBlockZ = playerChunk.z * chunkSize_;
+    
+    auto it = climateRegions_.begin();
+    while (it != climateRegions_.end()) {
+        int dx = it->first.x * regionBlocks + regionBlocks / 2 - playerBlockX;
+        int dz = it->first.z * regionBlocks + regionBlocks / 2 - playerBlockZ;
+        
+        if (std::max(std::abs(dx), std::abs(dz)) > keepBlocks) {
+            it = climateRegions_.erase(it);
         } else {
             ++it;
         }
     }
 }
 
+void ChunkTerrain::moveChunkToColdTier(Chunk* chunk) {
+    ColdChunk& cold = coldChunks_[chunk->coord];
+    stats_.coldBytes -= cold.data.size();
+    
+    cold.data.clear();
+    encodeChunk(chunk, cold.data);
+    cold.data.shrink_to_fit();
+    cold.isPersisted = chunk->isPersisted;
+    cold.isModified = chunk->isModified;
+    
+    stats_.coldBytes += cold.data.size();
+    stats_.coldChunks = static_cast<int>(coldChunks_.size());
+}
+
+bool ChunkTerrain::loadChunkFromColdTier(Chunk* chunk) {
+    auto it = coldChunks_.find(chunk->coord);
+    if (it == coldChunks_.end()) return false;
+    
+    auto start = std::chrono::steady_clock::now();
+    bool ok = decodeChunk(it->second.data, chunk);
+    auto end = std::chrono::steady_clock::now();
+    
+    if (ok) {
+        chunk->isPersisted = it->second.isPersisted;
+        chunk->isModified = it->second.isModified;
+        stats_.coldHits++;
+        stats_.decodeMicros += std::chrono::duration<double, std::micro>(end - start).count();
+    }
+    
+    stats_.coldBytes -= it->second.data.size();
+    coldChunks_.erase(it);
+    stats_.coldChunks = static_cast<int>(coldChunks_.size());
+    return ok;
+}
+
+void ChunkTerrain::unloadDistantColdChunks(const ChunkCoord& playerChunk) {
+    auto it = coldChunks_.begin();
+    while (it != coldChunks_.end()) {
+        int dx = it->first.x - playerChunk.x;
+        int dz = it->first.z - playerChunk.z;
+        int dist = std::max(std::abs(dx), std::abs(dz));
+        
+        // Without a region cache, edited chunks stay cold rather than being lost
+        bool keep = it->second.isModified && !regionStore_;
+        
+        if (dist > coldDistance_ && !keep) {
+            saveColdChunkToRegion(it->first, it->second);
+            stats_.coldBytes -= it->second.data.size();
+            it = coldChunks_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    stats_.coldChunks = static_cast<int>(coldChunks_.size());
+}
+
 void ChunkTerrain::render(Renderer& renderer, const Vec3& cameraPos) {
     renderer.beginBatch();
     
     // Only render chunks within visible range of camera (not all loaded chunks)
-    int viewDistance = 2; // Only render 2 chunks around camera for mobile performance
+    int viewDistance = viewDistance_; // Only render 2 chunks around camera for mobile performance
     ChunkCoord cameraChunk = worldToChunk(cameraPos.x, cameraPos.z);
     
     int renderedChunks = 0;
@@ -197,6 +866,8 @@ void ChunkTerrain::render(Renderer& renderer, const Vec3& cameraPos) {
         
         if (chunkDist > viewDistance) continue; // Skip distant chunks
         
+        chunk->lastAccessFrame = frame_;
+        
         // Render this chunk's blocks
         for (size_t i = 0; i < chunk->blockPositions.size(); i++) {
             renderer.addCubeToBatch(chunk->blockPositions[i], Vec3(2, 2, 2), chunk->blockColors[i]);
@@ -207,35 +878,152 @@ void ChunkTerrain::render(Renderer& renderer, const Vec3& cameraPos) {
     renderer.endBatch();
 }
 
+// Chunk not loaded, estimate height from the biome
+float ChunkTerrain::estimateHeight(float x, float z) const {
+    switch (getBiomeAt(x, z)) {
+        case BiomeType::WATER: return 6.0f;
+        case BiomeType::LAVA: return 8.0f;
+        case BiomeType::MOUNTAINS: return 30.0f;
+        case BiomeType::PLAINS:
+        default: return 10.0f;
+    }
+}
+
 float ChunkTerrain::getHeightAt(float x, float z) const {
     ChunkCoord coord = worldToChunk(x, z);
     auto it = chunks_.find(coord);
     
     if (it == chunks_.end()) {
-        // Chunk not loaded, estimate height
-        BiomeType biome = getBiomeAt(x, z);
-        switch (biome) {
-            case BiomeType::WATER: return 6.0f;
-            case BiomeType::LAVA: return 8.0f;
-            case BiomeType::MOUNTAINS: return 30.0f;
-            case BiomeType::PLAINS:
-            default: return 10.0f;
-        }
+        return estimateHeight(x, z);
     }
     
-    // Find highest block at this position
-    int blockX = static_cast<int>(x / 2.0f);
-    int blockZ = static_cast<int>(z / 2.0f);
-    float maxY = 0.0f;
+    // Column heights are kept per chunk, so this is a direct lookup
+    int blockX = worldToBlock(x) - coord.x * chunkSize_;
+    int blockZ = worldToBlock(z) - coord.z * chunkSize_;
+    
+    it->second->lastAccessFrame = frame_;
+    return it->second->heights[blockZ * chunkSize_ + blockX] * 2.0f;
+}
+
+void ChunkTerrain::sampleHeights(const float* xz, float* out, int count) const {
+    // Small direct-mapped cache of chunk lookups: each chunk touched costs one
+    // map lookup, further queries in it read the column heights directly
+    const int CACHE_SIZE = 256;
+    struct CachedChunk {
+        ChunkCoord coord;
+        Chunk* chunk;
+        bool valid;
+    };
+    CachedChunk cache[CACHE_SIZE];
+    for (int i = 0; i < CACHE_SIZE; i++) {
+        cache[i].valid = false;
+    }
     
-    for (const Vec3& pos : it->second->blockPositions) {
-        int bx = static_cast<int>(pos.x / 2.0f);
-        int bz = static_cast<int>(pos.z / 2.0f);
+    for (int i = 0; i < count; i++) {
+        float x = xz[i * 2], z = xz[i * 2 + 1];
+        int blockX = worldToBlock(x);
+        int blockZ = worldToBlock(z);
+        ChunkCoord coord = {floorDiv(blockX, chunkSize_), floorDiv(blockZ, chunkSize_)};
         
-        if (bx == blockX && bz == blockZ) {
-            maxY = std::max(maxY, pos.y + 2.0f);
+        uint32_t slot = ((static_cast<uint32_t>(coord.x) * 73856093u) ^ (static_cast<uint32_t>(coord.z) * 19349663u)) % CACHE_SIZE;
+        CachedChunk& cached = cache[slot];
+        if (!cached.valid || cached.coord.x != coord.x || cached.coord.z != coord.z) {
+            cached.coord = coord;
+            cached.chunk = findChunk(coord);
+            cached.valid = true;
+            if (cached.chunk) cached.chunk->lastAccessFrame = frame_;
+        }
+        
+        if (!cached.chunk) {
+            out[i] = estimateHeight(x, z);
+            continue;
+        }
+        int localX = blockX - coord.x * chunkSize_;
+        int localZ = blockZ - coord.z * chunkSize_;
+        out[i] = cached.chunk->heights[localZ * chunkSize_ + localX] * 2.0f;
+    }
+}
+
+void ChunkTerrain::setRegionDirectory(const std::string& directory) {
+    delete regionStore_;
+    regionStore_ = new RegionStore(directory);
+    
+    // Chunks already in memory have never been written to this store
+    for (auto& pair : chunks_) {
+        pair.second->isPersisted = false;
+    }
+    for (auto& pair : coldChunks_) {
+        pair.second.isPersisted = false;
+    }
+}
+
+void ChunkTerrain::flushRegions() {
+    if (!regionStore_) return;
+    
+    for (auto& pair : chunks_) {
+        saveChunkToRegion(pair.second);
+    }
+    for (auto& pair : coldChunks_) {
+        saveColdChunkToRegion(pair.first, pair.second);
+    }
+    regionStore_->closeAll();
+}
+
+// Payload: [biome][RLE blocks]; heights and render list are rebuilt on load
+void ChunkTerrain::encodeChunk(const Chunk* chunk, std::vector<uint8_t>& out) const {
+    out.push_back(static_cast<uint8_t>(chunk->biome));
+    ChunkCodec::encode(chunk->blocks.data(), chunk->blocks.size(), out);
+}
+
+bool ChunkTerrain::decodeChunk(const std::vector<uint8_t>& data, Chunk* chunk) {
+    if (data.empty()) return false;
+    
+    chunk->biome = static_cast<BiomeType>(data[0]);
+    if (!ChunkCodec::decode(data.data() + 1, data.size() - 1, chunk->blocks.data(), chunk->blocks.size())) {
+        return false;
+    }
+    
+    computeColumnHeights(chunk);
+    computeColumnBiomes(chunk);
+    return true;
+}
+
+void ChunkTerrain::computeColumnHeights(Chunk* chunk) {
+    for (int x = 0; x < chunkSize_; x++) {
+        for (int z = 0; z < chunkSize_; z++) {
+            const uint8_t* column = &chunk->blocks[blockIndex(x, 0, z)];
+            int height = maxHeight_;
+            while (height > 0 && column[height - 1] == static_cast<uint8_t>(TerrainBlock::AIR)) {
+                height--;
+            }
+            chunk->heights[z * chunkSize_ + x] = static_cast<uint8_t>(height);
         }
     }
+}
+
+bool ChunkTerrain::loadChunkFromRegion(Chunk* chunk) {
+    if (!regionStore_) return false;
+    
+    std::vector<uint8_t> payload;
+    if (!regionStore_->loadChunk(chunk->coord.x, chunk->coord.z, payload)) return false;
+    if (!decodeChunk(payload, chunk)) return false;
+    
+    chunk->isPersisted = true;
+    return true;
+}
+
+void ChunkTerrain::saveChunkToRegion(Chunk* chunk) {
+    if (!regionStore_ || chunk->isPersisted) return;
+    
+    std::vector<uint8_t> payload;
+    encodeChunk(chunk, payload);
+    
+    chunk->isPersisted = regionStore_->saveChunk(chunk->coord.x, chunk->coord.z, payload);
+}
+
+void ChunkTerrain::saveColdChunkToRegion(const ChunkCoord& coord, ColdChunk& cold) {
+    if (!regionStore_ || cold.isPersisted) return;
     
-    return maxY;
+    // Cold chunks are already in the on-disk encoding
+    cold.isPersisted = regionStore_->saveChunk(coord.x, coord.z, cold.data);
 }
@@ -48,7 +48,7 @@ bool CombatComponent::isRangedWeapon() const {
     return getWeaponStats(currentWeapon_).isRanged;
 }
 
-Attack CombatComponent::getWeaponStats(WeaponType weapon) const {
+Attack CombatComponent::getWeaponStats(WeaponType weapon) {
     switch (weapon) {
         case WeaponType::FIST:
             return {WeaponType::FIST, 5.0f, 2.0f, 0.5f, false};
@@ -63,40 +63,30 @@ Attack CombatComponent::getWeaponStats(WeaponType weapon) const {
     }
 }
 
-// Projectile implementation
-Projectile::Projectile(const Vec3& pos, const Vec3& dir, float damage, float speed)
-    : position_(pos)
-    , direction_(dir)
-    , damage_(damage)
-    , lifetime_(5.0f)
-    , active_(true)
-{
-    // Normalize direction
-    float len = std::sqrt(dir.x * dir.x + dir.y * dir.y + dir.z * dir.z);
-    if (len > 0.0001f) {
-        velocity_ = Vec3(dir.x / len * speed, dir.y / len * speed, dir.z / len * speed);
+// CombatEventBuffer implementation
+CombatEventBuffer::CombatEventBuffer(int capacity)
+    : events_(capacity > 0 ? capacity : 1)
+    , head_(0)
+    , count_(0)
+    , dropped_(0)
+{}
+
+void CombatEventBuffer::push(CombatEventType type, uint32_t entity, uint32_t generation, float amount, const Vec3& position) {
+    int capacity = static_cast<int>(events_.size());
+    events_[head_] = {static_cast<uint32_t>(type), entity, generation, amount, position.x, position.y, position.z};
+    head_ = (head_ + 1) % capacity;
+    if (count_ < capacity) {
+        count_++;
     } else {
-        velocity_ = Vec3(0, 0, speed);
+        dropped_++;
     }
 }
 
-void Projectile::update(float deltaTime) {
-    if (!active_) return;
-    
-    position_.x += velocity_.x * deltaTime;
-    position_.y += velocity_.y * deltaTime;
-    position_.z += velocity_.z * deltaTime;
-    
-    lifetime_ -= deltaTime;
-    if (lifetime_ <= 0.0f) {
-        active_ = false;
+const CombatEvent* CombatEventBuffer::data() {
+    // Only a full ring can have wrapped; the oldest event is then at head_
+    if (count_ == static_cast<int>(events_.size()) && head_ != 0) {
+        std::rotate(events_.begin(), events_.begin() + head_, events_.end());
+        head_ = 0;
     }
-}
-
-void Projectile::render(Renderer& renderer) {
-    if (!active_) return;
-    
-    // Render as small glowing cube
-    Color projectileColor(1.0f, 0.8f, 0.2f); // Yellow/gold
-    renderer.drawCube(position_, Vec3(0.3f, 0.3f, 0.3f), projectileColor);
+    return events_.data();
 }
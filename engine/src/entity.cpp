@@ -1,196 +1,552 @@
 #include "entity.h"
 #include "renderer.h"
+#include "chunk_terrain.h"
+#include "job_system.h"
+#include "flow_field.h"
+#include "pathfinder.h"
+#include "hit_test.h"
 #include <cmath>
 #include <algorithm>
+#include <utility>
 
-// Entity base implementation
-Entity::Entity(EntityType type, const Vec3& position)
-    : type_(type)
-    , position_(position)
-    , velocity_(0, 0, 0)
-    , combat_(100.0f)
-    , aiState_(AIState::IDLE)
-    , aiTimer_(0.0f)
-    , patrolTarget_(position)
-{
-    // Set health based on type
+static float maxHealthFor(EntityType type) {
     switch (type) {
         case EntityType::FRIENDLY_DRAGON:
-            combat_ = CombatComponent(200.0f);
-            break;
+            return 200.0f;
         case EntityType::ENEMY_DRAGON:
-            combat_ = CombatComponent(150.0f);
-            break;
+            return 150.0f;
         case EntityType::ENEMY_GOBLIN:
-            combat_ = CombatComponent(50.0f);
-            break;
+            return 50.0f;
         default:
-            combat_ = CombatComponent(100.0f);
+            return 100.0f;
+    }
+}
+
+static bool isEnemy(EntityType type) {
+    return type == EntityType::ENEMY_DRAGON || type == EntityType::ENEMY_GOBLIN;
+}
+
+// xorshift32, state must be non-zero
+static uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// EntityManager implementation
+EntityManager::EntityManager()
+    : aiFullDistance_(40.0f)
+    , aiActiveDistance_(96.0f)
+    , aiReducedInterval_(4)
+    , aiLodStats_{0, 0, 0}
+    , frame_(0)
+    , spawnCount_(0)
+    , grid_(8.0f)
+    , terrain_(nullptr)
+    , jobs_(nullptr)
+    , flowField_(nullptr)
+    , pathfinder_(nullptr)
+{}
+
+EntityManager::~EntityManager() {}
+
+EntityHandle EntityManager::addEntity(EntityType type, const Vec3& position, float maxHealth, WeaponType weapon, const Color& color) {
+    int index = getEntityCount();
+    
+    // Reuse a freed slot when there is one; its generation was bumped on removal
+    uint32_t slot;
+    if (!freeSlots_.empty()) {
+        slot = freeSlots_.back();
+        freeSlots_.pop_back();
+    } else {
+        slot = static_cast<uint32_t>(slotGeneration_.size());
+        slotGeneration_.push_back(1);
+        slotIndex_.push_back(-1);
+    }
+    slotIndex_[slot] = index;
+    
+    types_.push_back(type);
+    slots_.push_back(slot);
+    
+    transform_.x.push_back(position.x);
+    transform_.y.push_back(position.y);
+    transform_.z.push_back(position.z);
+    
+    velocity_.x.push_back(0);
+    velocity_.y.push_back(0);
+    velocity_.z.push_back(0);
+    
+    combat_.health.push_back(maxHealth);
+    combat_.maxHealth.push_back(maxHealth);
+    combat_.cooldown.push_back(0);
+    combat_.weapon.push_back(weapon);
+    
+    ai_.state.push_back(AIState::IDLE);
+    ai_.timer.push_back(0);
+    ai_.patrolX.push_back(position.x);
+    ai_.patrolZ.push_back(position.z);
+    ai_.path.emplace_back();
+    ai_.pathStep.push_back(0);
+    ai_.playerVisible.push_back(1);
+    ai_.lod.push_back(AILod::FULL);
+    ai_.pendingTime.push_back(0);
+    ai_.rng.push_back((++spawnCount_ * 2654435761u) | 1u);
+    
+    render_.color.push_back(color);
+    render_.animTimer.push_back(0);
+    
+    grid_.insert(index, position.x, position.z);
+    return EntityHandle(slot, slotGeneration_[slot]);
+}
+
+EntityHandle EntityManager::addDragon(EntityType type, const Vec3& position, const Color& color) {
+    return addEntity(type, position, maxHealthFor(type), WeaponType::FIST, color);
+}
+
+EntityHandle EntityManager::addGoblin(const Vec3& position) {
+    return addEntity(EntityType::ENEMY_GOBLIN, position, maxHealthFor(EntityType::ENEMY_GOBLIN),
+                     WeaponType::SWORD, Color(0.2f, 0.6f, 0.2f));
+}
+
+template <typename T>
+static void swapRemove(std::vector<T>& array, int index) {
+    array[index] = std::move(array.back());
+    array.pop_back();
+}
+
+void EntityManager::removeEntity(int index) {
+    int last = getEntityCount() - 1;
+    grid_.remove(index);
+    grid_.rename(last, index);
+    
+    // Retire the slot: outstanding handles stop resolving
+    uint32_t slot = slots_[index];
+    slotIndex_[slot] = -1;
+    if (++slotGeneration_[slot] == 0) slotGeneration_[slot] = 1;
+    freeSlots_.push_back(slot);
+    if (last != index) slotIndex_[slots_[last]] = index;
+    
+    swapRemove(types_, index);
+    swapRemove(slots_, index);
+    swapRemove(transform_.x, index);
+    swapRemove(transform_.y, index);
+    swapRemove(transform_.z, index);
+    swapRemove(velocity_.x, index);
+    swapRemove(velocity_.y, index);
+    swapRemove(velocity_.z, index);
+    swapRemove(combat_.health, index);
+    swapRemove(combat_.maxHealth, index);
+    swapRemove(combat_.cooldown, index);
+    swapRemove(combat_.weapon, index);
+    swapRemove(ai_.state, index);
+    swapRemove(ai_.timer, index);
+    swapRemove(ai_.patrolX, index);
+    swapRemove(ai_.patrolZ, index);
+    swapRemove(ai_.path, index);
+    swapRemove(ai_.pathStep, index);
+    swapRemove(ai_.playerVisible, index);
+    swapRemove(ai_.lod, index);
+    swapRemove(ai_.pendingTime, index);
+    swapRemove(ai_.rng, index);
+    swapRemove(render_.color, index);
+    swapRemove(render_.animTimer, index);
+}
+
+// One pass from the back: each removal moves the (already checked) last
+// entity into the hole, so mass deaths stay linear
+void EntityManager::removeDeadEntities() {
+    for (int i = getEntityCount() - 1; i >= 0; i--) {
+        if (combat_.health[i] <= 0) {
+            removeEntity(i);
+        }
     }
 }
 
-void Entity::update(float deltaTime, const Vec3& playerPos) {
-    combat_.update(deltaTime);
+bool EntityManager::despawnEntity(EntityHandle handle) {
+    int index = indexOf(handle);
+    if (index < 0) return false;
+    removeEntity(index);
+    return true;
+}
+
+void EntityManager::update(float deltaTime, const Vec3& playerPos) {
+    frame_++;
+    updateVisibility(playerPos);
+    updateCooldowns(deltaTime);
+    updateAI(deltaTime, playerPos);
+    integrate(deltaTime);
+    snapToGround();
+    removeDeadEntities();
+}
+
+void EntityManager::updateVisibility(const Vec3& playerPos) {
+    int count = getEntityCount();
+    for (int i = 0; i < count; i++) {
+        // Only enemies close enough to notice the player pay for a sight ray
+        if (!isEnemy(types_[i])) continue;
+        
+        float dx = playerPos.x - transform_.x[i];
+        float dy = playerPos.y - transform_.y[i];
+        float dz = playerPos.z - transform_.z[i];
+        if (dx*dx + dy*dy + dz*dz < 25.0f * 25.0f) {
+            ai_.playerVisible[i] = hasLineOfSight(getPosition(i), playerPos) ? 1 : 0;
+        }
+    }
+}
+
+void EntityManager::updateCooldowns(float deltaTime) {
+    float* cooldown = combat_.cooldown.data();
+    int count = getEntityCount();
+    for (int i = 0; i < count; i++) {
+        if (cooldown[i] > 0.0f) {
+            cooldown[i] -= deltaTime;
+        }
+    }
+}
+
+void EntityManager::updateAI(float deltaTime, const Vec3& playerPos) {
+    float fullSq = aiFullDistance_ * aiFullDistance_;
+    float activeSq = aiActiveDistance_ * aiActiveDistance_;
+    aiLodStats_ = {0, 0, 0};
+    aiDue_.clear();
+    aiDueTime_.clear();
     
-    // Only enemy entities use AI
-    if (type_ == EntityType::ENEMY_DRAGON || type_ == EntityType::ENEMY_GOBLIN) {
-        updateAI(deltaTime, playerPos);
+    // Classification stays serial (waking moves entities in the grid)
+    int count = getEntityCount();
+    for (int i = 0; i < count; i++) {
+        float dx = playerPos.x - transform_.x[i];
+        float dz = playerPos.z - transform_.z[i];
+        float distSq = dx*dx + dz*dz;
+        
+        AILod lod = distSq < fullSq ? AILod::FULL : (distSq < activeSq ? AILod::REDUCED : AILod::SLEEPING);
+        if (ai_.lod[i] == AILod::SLEEPING && lod != AILod::SLEEPING) {
+            wakeEntity(i);
+        } else if (lod == AILod::SLEEPING && ai_.lod[i] != AILod::SLEEPING) {
+            velocity_.x[i] = 0;
+            velocity_.y[i] = 0;
+            velocity_.z[i] = 0;
+        }
+        ai_.lod[i] = lod;
+        
+        switch (lod) {
+            case AILod::FULL:
+                aiLodStats_.full++;
+                break;
+            case AILod::REDUCED:
+                aiLodStats_.reduced++;
+                break;
+            case AILod::SLEEPING:
+                aiLodStats_.sleeping++;
+                break;
+        }
+        
+        // Only enemy entities use AI
+        if (!isEnemy(types_[i])) continue;
+        
+        float elapsed = ai_.pendingTime[i] + deltaTime;
+        if (lod == AILod::SLEEPING ||
+            (lod == AILod::REDUCED && (i + frame_) % aiReducedInterval_ != 0)) {
+            // Staggered by index so reduced ticks spread over frames
+            ai_.pendingTime[i] = elapsed;
+            continue;
+        }
+        ai_.pendingTime[i] = 0;
+        aiDue_.push_back(i);
+        aiDueTime_.push_back(elapsed);
     }
     
-    // Apply gravity and velocity
-    velocity_.y -= 9.8f * deltaTime;
-    position_.x += velocity_.x * deltaTime;
-    position_.y += velocity_.y * deltaTime;
-    position_.z += velocity_.z * deltaTime;
+    // runAI only writes the entity's own components
+    parallelFor(jobs_, static_cast<int>(aiDue_.size()), 256, [&](int begin, int end) {
+        for (int k = begin; k < end; k++) {
+            runAI(aiDue_[k], aiDueTime_[k], playerPos);
+        }
+    });
+}
+
+void EntityManager::wakeEntity(int index) {
+    float elapsed = ai_.pendingTime[index];
+    ai_.pendingTime[index] = 0;
+    combat_.cooldown[index] = std::max(0.0f, combat_.cooldown[index] - elapsed);
     
-    // Simple ground collision
-    if (position_.y < 1.0f) {
-        position_.y = 1.0f;
-        velocity_.y = 0;
+    // Cheap catch-up: walk on along the patrol route, anything that
+    // involved the player has long since given up
+    switch (ai_.state[index]) {
+        case AIState::PATROL: {
+            float step = 3.0f * elapsed;
+            for (;;) {
+                float dx = ai_.patrolX[index] - transform_.x[index];
+                float dz = ai_.patrolZ[index] - transform_.z[index];
+                float dist = std::sqrt(dx*dx + dz*dz);
+                if (step < dist) {
+                    transform_.x[index] += dx / dist * step;
+                    transform_.z[index] += dz / dist * step;
+                    ai_.timer[index] += elapsed;
+                    break;
+                }
+                
+                transform_.x[index] = ai_.patrolX[index];
+                transform_.z[index] = ai_.patrolZ[index];
+                step -= dist;
+                if (!advancePatrol(index)) {
+                    ai_.state[index] = AIState::IDLE;
+                    ai_.timer[index] = 0;
+                    break;
+                }
+            }
+            grid_.move(index, transform_.x[index], transform_.z[index]);
+            break;
+        }
+        case AIState::IDLE:
+            ai_.timer[index] += elapsed;
+            break;
+        default:
+            ai_.state[index] = AIState::IDLE;
+            ai_.timer[index] = 0;
+            break;
     }
 }
 
-void Entity::updateAI(float deltaTime, const Vec3& playerPos) {
-    aiTimer_ += deltaTime;
-    float distToPlayer = distanceTo(playerPos);
+void EntityManager::runAI(int i, float deltaTime, const Vec3& playerPos) {
+    AIState& state = ai_.state[i];
+    float& timer = ai_.timer[i];
+    timer += deltaTime;
     
-    switch (aiState_) {
+    float px = transform_.x[i], py = transform_.y[i], pz = transform_.z[i];
+    float dx = playerPos.x - px, dy = playerPos.y - py, dz = playerPos.z - pz;
+    float distToPlayer = std::sqrt(dx*dx + dy*dy + dz*dz);
+    bool visible = ai_.playerVisible[i] != 0;
+    float attackRange = CombatComponent::getWeaponStats(combat_.weapon[i]).range;
+    
+    switch (state) {
         case AIState::IDLE:
             // Switch to patrol after random time
-            if (aiTimer_ > 3.0f) {
-                aiState_ = AIState::PATROL;
-                aiTimer_ = 0;
-                // Random patrol point
-                patrolTarget_ = Vec3(
-                    position_.x + (rand() % 20 - 10),
-                    position_.y,
-                    position_.z + (rand() % 20 - 10)
-                );
+            if (timer > 3.0f) {
+                timer = 0;
+                if (pathfinder_) {
+                    // Random patrol point further out, reached around
+                    // slopes and lava; try again later if there is no way
+                    Vec3 goal(px + static_cast<float>(nextRandom(ai_.rng[i]) % 40) - 20.0f, py,
+                              pz + static_cast<float>(nextRandom(ai_.rng[i]) % 40) - 20.0f);
+                    std::vector<Vec3>& path = ai_.path[i];
+                    if (pathfinder_->findPath(Vec3(px, py, pz), goal, path) && !path.empty()) {
+                        state = AIState::PATROL;
+                        ai_.pathStep[i] = 0;
+                        ai_.patrolX[i] = path[0].x;
+                        ai_.patrolZ[i] = path[0].z;
+                    }
+                } else {
+                    state = AIState::PATROL;
+                    // Random patrol point
+                    ai_.patrolX[i] = px + static_cast<float>(nextRandom(ai_.rng[i]) % 20) - 10.0f;
+                    ai_.patrolZ[i] = pz + static_cast<float>(nextRandom(ai_.rng[i]) % 20) - 10.0f;
+                }
             }
             
-            // If player close, chase
-            if (distToPlayer < 15.0f) {
-                aiState_ = AIState::CHASE;
-                aiTimer_ = 0;
+            // If player close and in sight, chase
+            if (distToPlayer < 15.0f && visible) {
+                state = AIState::CHASE;
+                timer = 0;
             }
             break;
             
-        case AIState::PATROL:
-            moveTowards(patrolTarget_, 3.0f, deltaTime);
+        case AIState::PATROL: {
+            moveTowards(i, ai_.patrolX[i], ai_.patrolZ[i], 3.0f);
             
-            // Reached patrol point
-            if (distanceTo(patrolTarget_) < 2.0f) {
-                aiState_ = AIState::IDLE;
-                aiTimer_ = 0;
+            // Reached the waypoint: on to the next one, idle at the end.
+            // Route waypoints are one block apart, so they need a closer reach.
+            float tx = ai_.patrolX[i] - px, tz = ai_.patrolZ[i] - pz;
+            float reach = ai_.path[i].empty() ? 2.0f : 0.5f;
+            if (tx*tx + tz*tz < reach * reach && !advancePatrol(i)) {
+                state = AIState::IDLE;
+                timer = 0;
+                velocity_.x[i] = 0;  // Stand still instead of drifting on while idle
+                velocity_.z[i] = 0;
             }
             
             // Player detected
-            if (distToPlayer < 15.0f) {
-                aiState_ = AIState::CHASE;
-                aiTimer_ = 0;
+            if (distToPlayer < 15.0f && visible) {
+                state = AIState::CHASE;
+                timer = 0;
             }
             break;
-            
-        case AIState::CHASE:
-            moveTowards(playerPos, 5.0f, deltaTime);
+        }
+        
+        case AIState::CHASE: {
+            // Shared field around the player: one lookup instead of a path
+            // search per chaser. Straight line in the player's cell or off the field.
+            float fx, fz;
+            if (flowField_ && flowField_->sample(px, pz, fx, fz)) {
+                velocity_.x[i] = fx * 5.0f;
+                velocity_.z[i] = fz * 5.0f;
+            } else {
+                moveTowards(i, playerPos.x, playerPos.z, 5.0f);
+            }
             
             // In attack range
-            if (distToPlayer < combat_.getAttackRange()) {
-                aiState_ = AIState::ATTACK;
-                aiTimer_ = 0;
+            if (distToPlayer < attackRange) {
+                state = AIState::ATTACK;
+                timer = 0;
             }
             
-            // Lost player
-            if (distToPlayer > 25.0f) {
-                aiState_ = AIState::IDLE;
-                aiTimer_ = 0;
+            // Lost player (out of range, or behind terrain and not close)
+            if (distToPlayer > 25.0f || (!visible && distToPlayer > 5.0f)) {
+                state = AIState::IDLE;
+                timer = 0;
             }
             break;
+        }
             
         case AIState::ATTACK:
             // Stop moving, face player
-            velocity_.x *= 0.9f;
-            velocity_.z *= 0.9f;
+            velocity_.x[i] *= 0.9f;
+            velocity_.z[i] *= 0.9f;
             
             // Attack if possible
-            if (combat_.canAttack()) {
-                combat_.performAttack(combat_.getWeapon());
+            if (combat_.cooldown[i] <= 0.0f) {
+                combat_.cooldown[i] = CombatComponent::getWeaponStats(combat_.weapon[i]).cooldown;
                 // Damage would be applied by collision detection
             }
             
             // Player moved away
-            if (distToPlayer > combat_.getAttackRange() * 1.5f) {
-                aiState_ = AIState::CHASE;
-                aiTimer_ = 0;
+            if (distToPlayer > attackRange * 1.5f) {
+                state = AIState::CHASE;
+                timer = 0;
             }
             break;
             
-        case AIState::FLEE:
+        case AIState::FLEE: {
             // Move away from player
-            Vec3 fleeDir = Vec3(
-                position_.x - playerPos.x,
-                0,
-                position_.z - playerPos.z
-            );
-            float len = std::sqrt(fleeDir.x * fleeDir.x + fleeDir.z * fleeDir.z);
+            float len = std::sqrt(dx*dx + dz*dz);
             if (len > 0.001f) {
-                velocity_.x = (fleeDir.x / len) * 6.0f;
-                velocity_.z = (fleeDir.z / len) * 6.0f;
+                velocity_.x[i] = (-dx / len) * 6.0f;
+                velocity_.z[i] = (-dz / len) * 6.0f;
             }
             
             // Safe distance
             if (distToPlayer > 20.0f) {
-                aiState_ = AIState::IDLE;
-                aiTimer_ = 0;
+                state = AIState::IDLE;
+                timer = 0;
             }
             break;
+        }
     }
 }
 
-void Entity::moveTowards(const Vec3& target, float speed, float deltaTime) {
-    Vec3 dir = Vec3(target.x - position_.x, 0, target.z - position_.z);
-    float len = std::sqrt(dir.x * dir.x + dir.z * dir.z);
+void EntityManager::integrate(float deltaTime) {
+    float* x = transform_.x.data();
+    float* y = transform_.y.data();
+    float* z = transform_.z.data();
+    float* vx = velocity_.x.data();
+    float* vy = velocity_.y.data();
+    float* vz = velocity_.z.data();
+    const AILod* lod = ai_.lod.data();
     
-    if (len > 0.1f) {
-        velocity_.x = (dir.x / len) * speed;
-        velocity_.z = (dir.z / len) * speed;
-    } else {
-        velocity_.x = 0;
-        velocity_.z = 0;
+    int count = getEntityCount();
+    parallelFor(jobs_, count, 1024, [=](int begin, int end) {
+        for (int i = begin; i < end; i++) {
+            if (lod[i] == AILod::SLEEPING) continue;
+            
+            // Apply gravity and velocity
+            vy[i] -= 9.8f * deltaTime;
+            x[i] += vx[i] * deltaTime;
+            y[i] += vy[i] * deltaTime;
+            z[i] += vz[i] * deltaTime;
+        }
+    });
+    
+    // The grid is shared, so it follows in a serial pass
+    for (int i = 0; i < count; i++) {
+        if (lod[i] != AILod::SLEEPING) {
+            grid_.move(i, x[i], z[i]);
+        }
     }
 }
 
-float Entity::distanceTo(const Vec3& target) const {
-    float dx = target.x - position_.x;
-    float dy = target.y - position_.y;
-    float dz = target.z - position_.z;
-    return std::sqrt(dx*dx + dy*dy + dz*dz);
+// Entities land on the terrain surface under them; the heights come from
+// one batched terrain query
+void EntityManager::snapToGround() {
+    int count = getEntityCount();
+    groundQuery_.resize(count * 2);
+    groundHeights_.assign(count, 1.0f);
+    for (int i = 0; i < count; i++) {
+        groundQuery_[i * 2] = transform_.x[i];
+        groundQuery_[i * 2 + 1] = transform_.z[i];
+    }
+    if (terrain_) {
+        terrain_->sampleHeights(groundQuery_.data(), groundHeights_.data(), count);
+    }
+    
+    float* y = transform_.y.data();
+    float* vy = velocity_.y.data();
+    for (int i = 0; i < count; i++) {
+        if (y[i] < groundHeights_[i]) {
+            y[i] = groundHeights_[i];
+            vy[i] = 0;
+        }
+    }
 }
 
-void Entity::render(Renderer& renderer) {
-    // Base entity renders as simple cube
-    Color entityColor(0.5f, 0.5f, 0.5f);
-    renderer.drawCube(position_, Vec3(1, 2, 1), entityColor);
+// Moves the patrol waypoint along the route; false once the route is done
+bool EntityManager::advancePatrol(int index) {
+    std::vector<Vec3>& path = ai_.path[index];
+    int next = ai_.pathStep[index] + 1;
+    if (next >= static_cast<int>(path.size())) {
+        path.clear();
+        return false;
+    }
+    ai_.pathStep[index] = next;
+    ai_.patrolX[index] = path[next].x;
+    ai_.patrolZ[index] = path[next].z;
+    return true;
+}
+
+void EntityManager::moveTowards(int index, float targetX, float targetZ, float speed) {
+    float dx = targetX - transform_.x[index];
+    float dz = targetZ - transform_.z[index];
+    float len = std::sqrt(dx * dx + dz * dz);
+    
+    if (len > 0.1f) {
+        velocity_.x[index] = (dx / len) * speed;
+        velocity_.z[index] = (dz / len) * speed;
+    } else {
+        velocity_.x[index] = 0;
+        velocity_.z[index] = 0;
+    }
 }
 
-// DragonEntity implementation
-DragonEntity::DragonEntity(EntityType type, const Vec3& position, const Color& color)
-    : Entity(type, position)
-    , color_(color)
-    , wingFlap_(0.0f)
-{
-    combat_.setWeapon(WeaponType::FIST);
+void EntityManager::render(Renderer& renderer) {
+    renderer.beginBatch(); // Start batching all entities
+    
+    int count = getEntityCount();
+    for (int i = 0; i < count; i++) {
+        switch (types_[i]) {
+            case EntityType::FRIENDLY_DRAGON:
+            case EntityType::ENEMY_DRAGON:
+                renderDragon(renderer, i);
+                break;
+            case EntityType::ENEMY_GOBLIN:
+                renderGoblin(renderer, i);
+                break;
+            default:
+                // Other entities render as a simple cube
+                renderer.addCubeToBatch(getPosition(i), Vec3(1, 2, 1), Color(0.5f, 0.5f, 0.5f));
+                break;
+        }
+    }
+    
+    renderer.endBatch(); // Single draw call for ALL entities!
 }
 
-void DragonEntity::render(Renderer& renderer) {
-    // Dragon parts added to batch (no beginBatch here - done in EntityManager)
-    Vec3 pos = position_;
+void EntityManager::renderDragon(Renderer& renderer, int index) {
+    Vec3 pos = getPosition(index);
+    const Color& color = render_.color[index];
     
     // Body
-    renderer.addCubeToBatch(Vec3(pos.x, pos.y + 1, pos.z), Vec3(2, 1.5f, 3), color_);
+    renderer.addCubeToBatch(Vec3(pos.x, pos.y + 1, pos.z), Vec3(2, 1.5f, 3), color);
     
     // Head
-    Color headColor(color_.r * 0.9f, color_.g * 0.9f, color_.b * 0.9f);
+    Color headColor(color.r * 0.9f, color.g * 0.9f, color.b * 0.9f);
     renderer.addCubeToBatch(Vec3(pos.x, pos.y + 1.5f, pos.z + 2), Vec3(1.2f, 1.2f, 1.2f), headColor);
     
     // Eyes
@@ -199,28 +555,21 @@ void DragonEntity::render(Renderer& renderer) {
     renderer.addCubeToBatch(Vec3(pos.x + 0.3f, pos.y + 1.7f, pos.z + 2.5f), Vec3(0.2f, 0.2f, 0.2f), eyeColor);
     
     // Tail
-    renderer.addCubeToBatch(Vec3(pos.x, pos.y + 0.5f, pos.z - 2), Vec3(0.5f, 0.5f, 1.5f), color_);
+    renderer.addCubeToBatch(Vec3(pos.x, pos.y + 0.5f, pos.z - 2), Vec3(0.5f, 0.5f, 1.5f), color);
     
     // Wings (simple)
-    float wingOffset = std::sin(wingFlap_) * 0.3f;
-    Color wingColor(color_.r * 0.7f, color_.g * 0.7f, color_.b * 0.7f);
+    float& wingFlap = render_.animTimer[index];
+    float wingOffset = std::sin(wingFlap) * 0.3f;
+    Color wingColor(color.r * 0.7f, color.g * 0.7f, color.b * 0.7f);
     renderer.addCubeToBatch(Vec3(pos.x - 1.5f, pos.y + 1.5f + wingOffset, pos.z), Vec3(1, 0.1f, 2), wingColor);
     renderer.addCubeToBatch(Vec3(pos.x + 1.5f, pos.y + 1.5f - wingOffset, pos.z), Vec3(1, 0.1f, 2), wingColor);
     
-    wingFlap_ += 0.1f;
+    wingFlap += 0.1f;
 }
 
-// GoblinEntity implementation
-GoblinEntity::GoblinEntity(const Vec3& position)
-    : Entity(EntityType::ENEMY_GOBLIN, position)
-    , animTimer_(0.0f)
-{
-    combat_.setWeapon(WeaponType::SWORD);
-}
-
-void GoblinEntity::render(Renderer& renderer) {
-    Vec3 pos = position_;
-    Color goblinGreen(0.2f, 0.6f, 0.2f);
+void EntityManager::renderGoblin(Renderer& renderer, int index) {
+    Vec3 pos = getPosition(index);
+    const Color& goblinGreen = render_.color[index];
     
     // Body
     renderer.addCubeToBatch(Vec3(pos.x, pos.y + 0.5f, pos.z), Vec3(0.6f, 0.8f, 0.4f), goblinGreen);
@@ -238,92 +587,129 @@ void GoblinEntity::render(Renderer& renderer) {
     renderer.addCubeToBatch(Vec3(pos.x + 0.5f, pos.y + 0.6f, pos.z), Vec3(0.2f, 0.6f, 0.2f), goblinGreen);
 }
 
-// EntityManager implementation
-EntityManager::EntityManager() {}
+bool EntityManager::hasLineOfSight(const Vec3& from, const Vec3& to) const {
+    if (!terrain_) return true;
+    
+    // Eye height above whichever is higher, the entity or the ground under it
+    Vec3 eye(from.x, std::max(from.y, terrain_->getHeightAt(from.x, from.z)) + 1.0f, from.z);
+    Vec3 target(to.x, to.y + 1.0f, to.z);
+    Vec3 dir = target - eye;
+    
+    TerrainRayHit hit;
+    return !terrain_->raycast(eye, dir, dir.length(), hit);
+}
 
-EntityManager::~EntityManager() {
-    for (Entity* entity : entities_) {
-        delete entity;
+EntityHandle EntityManager::getEntityInRange(const Vec3& position, float range, EntityType excludeType) const {
+    candidates_.clear();
+    grid_.query(position.x - range, position.z - range, position.x + range, position.z + range, candidates_);
+    
+    float bestDistSq = range * range;
+    int best = -1;
+    for (int i : candidates_) {
+        if (types_[i] == excludeType) continue;
+        if (combat_.health[i] <= 0) continue;
+        
+        float dx = transform_.x[i] - position.x;
+        float dy = transform_.y[i] - position.y;
+        float dz = transform_.z[i] - position.z;
+        float distSq = dx*dx + dy*dy + dz*dz;
+        
+        if (distSq <= bestDistSq) {
+            bestDistSq = distSq;
+            best = i;
+        }
     }
-    entities_.clear();
+    return best >= 0 ? getHandle(best) : EntityHandle();
 }
 
-void EntityManager::addDragon(EntityType type, const Vec3& position, const Color& color) {
-    entities_.push_back(new DragonEntity(type, position, color));
+int EntityManager::gatherCandidates(float minX, float minZ, float maxX, float maxZ) const {
+    candidates_.clear();
+    grid_.query(minX, minZ, maxX, maxZ, candidates_);
+    
+    // Drop the dead in place, then lay the positions out for the kernels
+    candidates_.erase(std::remove_if(candidates_.begin(), candidates_.end(), [this](int i) {
+        return combat_.health[i] <= 0;
+    }), candidates_.end());
+    
+    size_t count = candidates_.size();
+    candidateX_.resize(count);
+    candidateY_.resize(count);
+    candidateZ_.resize(count);
+    hitMask_.resize(count);
+    for (size_t k = 0; k < count; k++) {
+        int i = candidates_[k];
+        candidateX_[k] = transform_.x[i];
+        candidateY_[k] = transform_.y[i];
+        candidateZ_[k] = transform_.z[i];
+    }
+    return static_cast<int>(count);
 }
 
-void EntityManager::addGoblin(const Vec3& position) {
-    entities_.push_back(new GoblinEntity(position));
+void EntityManager::collectHits(int count, std::vector<EntityHandle>& out) const {
+    for (int k = 0; k < count; k++) {
+        if (hitMask_[k]) out.push_back(getHandle(candidates_[k]));
+    }
 }
 
-void EntityManager::removeDeadEntities() {
-    auto it = entities_.begin();
-    while (it != entities_.end()) {
-        if (!(*it)->isAlive()) {
-            delete *it;
-            it = entities_.erase(it);
-        } else {
-            ++it;
-        }
+void EntityManager::getEntitiesInRange(const Vec3& position, float range, std::vector<EntityHandle>& out) const {
+    out.clear();
+    int count = gatherCandidates(position.x - range, position.z - range, position.x + range, position.z + range);
+    if (sphereHitMask(candidateX_.data(), candidateY_.data(), candidateZ_.data(), count, position, range, hitMask_.data()) > 0) {
+        collectHits(count, out);
     }
 }
 
-void EntityManager::update(float deltaTime, const Vec3& playerPos) {
-    for (Entity* entity : entities_) {
-        entity->update(deltaTime, playerPos);
+void EntityManager::getEntitiesInCone(const Vec3& apex, const Vec3& axis, float range, float halfAngle,
+                                      std::vector<EntityHandle>& out) const {
+    out.clear();
+    Vec3 direction = axis.normalize();
+    int count = gatherCandidates(apex.x - range, apex.z - range, apex.x + range, apex.z + range);
+    if (coneHitMask(candidateX_.data(), candidateY_.data(), candidateZ_.data(), count,
+                    apex, direction, range, halfAngle, hitMask_.data()) > 0) {
+        collectHits(count, out);
     }
-    removeDeadEntities();
 }
 
-void EntityManager::render(Renderer& renderer) {
-    renderer.beginBatch(); // Start batching all entities
-    
-    for (Entity* entity : entities_) {
-        entity->render(renderer);
+void EntityManager::getEntitiesInCapsule(const Vec3& a, const Vec3& b, float radius, std::vector<EntityHandle>& out) const {
+    out.clear();
+    int count = gatherCandidates(std::min(a.x, b.x) - radius, std::min(a.z, b.z) - radius,
+                                 std::max(a.x, b.x) + radius, std::max(a.z, b.z) + radius);
+    if (capsuleHitMask(candidateX_.data(), candidateY_.data(), candidateZ_.data(), count, a, b, radius, hitMask_.data()) > 0) {
+        collectHits(count, out);
     }
-    
-    renderer.endBatch(); // Single draw call for ALL entities!
 }
 
-Entity* EntityManager::getEntityInRange(const Vec3& position, float range, EntityType excludeType) {
-    for (Entity* entity : entities_) {
-        if (entity->getType() == excludeType) continue;
-        if (!entity->isAlive()) continue;
-        
-        Vec3 ePos = entity->getPosition();
-        float dx = ePos.x - position.x;
-        float dy = ePos.y - position.y;
-        float dz = ePos.z - position.z;
-        float dist = std::sqrt(dx*dx + dy*dy + dz*dz);
+void EntityManager::getEntitiesInBox(const Vec3& minCorner, const Vec3& maxCorner, std::vector<EntityHandle>& out) const {
+    out.clear();
+    candidates_.clear();
+    grid_.query(minCorner.x, minCorner.z, maxCorner.x, maxCorner.z, candidates_);
+    
+    for (int i : candidates_) {
+        if (combat_.health[i] <= 0) continue;
         
-        if (dist <= range) {
-            return entity;
+        float x = transform_.x[i], y = transform_.y[i], z = transform_.z[i];
+        if (x >= minCorner.x && x <= maxCorner.x &&
+            y >= minCorner.y && y <= maxCorner.y &&
+            z >= minCorner.z && z <= maxCorner.z) {
+            out.push_back(getHandle(i));
         }
     }
-    return nullptr;
 }
 
-std::vector<Entity*> EntityManager::getEntitiesInRange(const Vec3& position, float range) {
-    std::vector<Entity*> result;
-    for (Entity* entity : entities_) {
-        if (!entity->isAlive()) continue;
-        
-        Vec3 ePos = entity->getPosition();
-        float dx = ePos.x - position.x;
-        float dy = ePos.y - position.y;
-        float dz = ePos.z - position.z;
-        float dist = std::sqrt(dx*dx + dy*dy + dz*dz);
-        
-        if (dist <= range) {
-            result.push_back(entity);
-        }
-    }
-    return result;
+bool EntityManager::damageEntity(EntityHandle handle, float amount, bool* killed) {
+    int index = indexOf(handle);
+    if (killed) *killed = false;
+    if (index < 0) return false;
+    
+    float before = combat_.health[index];
+    combat_.health[index] = std::max(0.0f, before - amount);
+    if (killed) *killed = before > 0.0f && combat_.health[index] <= 0.0f;
+    return true;
 }
 
-Entity* EntityManager::getEntity(int index) {
-    if (index >= 0 && index < entities_.size()) {
-        return entities_[index];
-    }
-    return nullptr;
+bool EntityManager::setHealth(EntityHandle handle, float health) {
+    int index = indexOf(handle);
+    if (index < 0) return false;
+    combat_.health[index] = std::max(0.0f, std::min(combat_.maxHealth[index], health));
+    return true;
 }
@@ -0,0 +1,149 @@
+#include "flow_field.h"
+#include "chunk_terrain.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+// 8-neighbourhood, opposite directions paired (n ^ 1); diagonals cost sqrt(2)
+static const int NEIGHBOUR_X[8] = {1, -1, 0, 0, 1, -1, 1, -1};
+static const int NEIGHBOUR_Z[8] = {0, 0, 1, -1, 1, -1, -1, 1};
+static const float NEIGHBOUR_COST[8] = {1, 1, 1, 1, 1.41421356f, 1.41421356f, 1.41421356f, 1.41421356f};
+
+FlowField::FlowField(int radius)
+    : radius_(radius)
+    , size_(radius * 2 + 1)
+    , originX_(0)
+    , originZ_(0)
+    , targetX_(0)
+    , targetZ_(0)
+    , valid_(false)
+    , buildCount_(0)
+    , buildMicros_(0)
+{
+    int cells = size_ * size_;
+    heights_.resize(cells);
+    costs_.resize(cells);
+    dist_.resize(cells);
+    next_.resize(cells);
+    query_.resize(cells * 2);
+}
+
+bool FlowField::update(const ChunkTerrain& terrain, const Vec3& target) {
+    int blockX = ChunkTerrain::worldToBlock(target.x);
+    int blockZ = ChunkTerrain::worldToBlock(target.z);
+    if (valid_ && blockX == targetX_ && blockZ == targetZ_) return false;
+    
+    targetX_ = blockX;
+    targetZ_ = blockZ;
+    originX_ = blockX - radius_;
+    originZ_ = blockZ - radius_;
+    build(terrain);
+    valid_ = true;
+    return true;
+}
+
+void FlowField::build(const ChunkTerrain& terrain) {
+    auto start = std::chrono::steady_clock::now();
+    int cells = size_ * size_;
+    
+    // Heights for every cell in one batched query, then a cost per biome
+    for (int j = 0; j < size_; j++) {
+        for (int i = 0; i < size_; i++) {
+            int cell = j * size_ + i;
+            query_[cell * 2] = (originX_ + i) * 2.0f;
+            query_[cell * 2 + 1] = (originZ_ + j) * 2.0f;
+        }
+    }
+    terrain.sampleHeights(query_.data(), heights_.data(), cells);
+    
+    for (int cell = 0; cell < cells; cell++) {
+        switch (terrain.getBiomeAt(query_[cell * 2], query_[cell * 2 + 1])) {
+            case BiomeType::LAVA: costs_[cell] = -1.0f; break;
+            case BiomeType::WATER: costs_[cell] = 4.0f; break;
+            default: costs_[cell] = 1.0f; break;
+        }
+        dist_[cell] = std::numeric_limits<float>::max();
+        next_[cell] = -1;
+    }
+    
+    // Dijkstra outwards from the target. Edges are walked in reverse (from
+    // the neighbour towards the cell closer to the target), so climbs are
+    // charged in the direction a chaser would actually move.
+    typedef std::pair<float, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    int targetCell = radius_ * size_ + radius_;
+    dist_[targetCell] = 0.0f;
+    open.push({0.0f, targetCell});
+    
+    while (!open.empty()) {
+        Entry entry = open.top();
+        open.pop();
+        int cell = entry.second;
+        if (entry.first > dist_[cell]) continue;
+        
+        int ci = cell % size_, cj = cell / size_;
+        for (int n = 0; n < 8; n++) {
+            int ni = ci + NEIGHBOUR_X[n], nj = cj + NEIGHBOUR_Z[n];
+            if (ni < 0 || nj < 0 || ni >= size_ || nj >= size_) continue;
+            
+            int neighbour = nj * size_ + ni;
+            if (costs_[neighbour] < 0.0f) continue;
+            
+            // Moving neighbour -> cell, in blocks: climbing costs more than
+            // dropping, and both grow with the height of the step
+            float step = (heights_[cell] - heights_[neighbour]) * 0.5f;
+            float slope = step > 0.0f ? 1.0f + step * step * 2.0f : 1.0f - step * 0.5f;
+            
+            // Diagonals only between open corners of similar height, so
+            // walkers never clip a cliff edge or a blocked cell
+            if (n >= 4) {
+                int cornerA = cj * size_ + ni;
+                int cornerB = nj * size_ + ci;
+                float low = std::min(heights_[cell], heights_[neighbour]);
+                float high = std::max(heights_[cell], heights_[neighbour]);
+                if (costs_[cornerA] < 0.0f || costs_[cornerB] < 0.0f ||
+                    std::max(heights_[cornerA], heights_[cornerB]) > low + 2.0f ||
+                    std::min(heights_[cornerA], heights_[cornerB]) < high - 2.0f) {
+                    continue;
+                }
+            }
+            
+            float cost = NEIGHBOUR_COST[n] * costs_[neighbour] * slope;
+            float d = dist_[cell] + cost;
+            if (d < dist_[neighbour]) {
+                dist_[neighbour] = d;
+                next_[neighbour] = static_cast<int8_t>(n ^ 1);  // Opposite direction
+                open.push({d, neighbour});
+            }
+        }
+    }
+    
+    buildCount_++;
+    buildMicros_ = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool FlowField::sample(float x, float z, float& dirX, float& dirZ) const {
+    if (!valid_) return false;
+    
+    int i = ChunkTerrain::worldToBlock(x) - originX_;
+    int j = ChunkTerrain::worldToBlock(z) - originZ_;
+    if (i < 0 || j < 0 || i >= size_ || j >= size_) return false;
+    
+    int n = next_[j * size_ + i];
+    if (n < 0) return false;
+    
+    // Steer at the centre of the next cell rather than along the fixed
+    // direction, so walkers off the cell centre cannot cut a corner into a
+    // cell that points back
+    float dx = (originX_ + i + NEIGHBOUR_X[n]) * 2.0f - x;
+    float dz = (originZ_ + j + NEIGHBOUR_Z[n]) * 2.0f - z;
+    float len = std::sqrt(dx * dx + dz * dz);
+    if (len < 0.0001f) return false;
+    
+    dirX = dx / len;
+    dirZ = dz / len;
+    return true;
+}
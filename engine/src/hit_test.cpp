@@ -0,0 +1,172 @@
+#include "hit_test.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define DC_HIT_SIMD 1
+
+typedef v128_t Float4;
+static inline Float4 load4(const float* p) { return wasm_v128_load(p); }
+static inline Float4 splat4(float v) { return wasm_f32x4_splat(v); }
+static inline Float4 add4(Float4 a, Float4 b) { return wasm_f32x4_add(a, b); }
+static inline Float4 sub4(Float4 a, Float4 b) { return wasm_f32x4_sub(a, b); }
+static inline Float4 mul4(Float4 a, Float4 b) { return wasm_f32x4_mul(a, b); }
+static inline Float4 min4(Float4 a, Float4 b) { return wasm_f32x4_pmin(a, b); }
+static inline Float4 max4(Float4 a, Float4 b) { return wasm_f32x4_pmax(a, b); }
+static inline Float4 le4(Float4 a, Float4 b) { return wasm_f32x4_le(a, b); }
+static inline Float4 and4(Float4 a, Float4 b) { return wasm_v128_and(a, b); }
+static inline int bits4(Float4 m) { return static_cast<int>(wasm_i32x4_bitmask(m)); }
+
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DC_HIT_SIMD 1
+
+typedef __m128 Float4;
+static inline Float4 load4(const float* p) { return _mm_loadu_ps(p); }
+static inline Float4 splat4(float v) { return _mm_set1_ps(v); }
+static inline Float4 add4(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+static inline Float4 sub4(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+static inline Float4 mul4(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+static inline Float4 min4(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+static inline Float4 max4(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+static inline Float4 le4(Float4 a, Float4 b) { return _mm_cmple_ps(a, b); }
+static inline Float4 and4(Float4 a, Float4 b) { return _mm_and_ps(a, b); }
+static inline int bits4(Float4 m) { return _mm_movemask_ps(m); }
+
+#else
+#define DC_HIT_SIMD 0
+#endif
+
+// Writes four mask bytes from a 4-bit lane mask, returns the hits
+static inline int storeMask(int bits, uint8_t* mask) {
+    mask[0] = bits & 1;
+    mask[1] = (bits >> 1) & 1;
+    mask[2] = (bits >> 2) & 1;
+    mask[3] = (bits >> 3) & 1;
+    return mask[0] + mask[1] + mask[2] + mask[3];
+}
+
+// The scalar tests, also used for the remainder after the last full group
+static inline bool inSphere(float px, float py, float pz, const Vec3& c, float radiusSq) {
+    float dx = px - c.x, dy = py - c.y, dz = pz - c.z;
+    return dx*dx + dy*dy + dz*dz <= radiusSq;
+}
+
+// Inside the cone: along the axis (d >= 0), within range, and
+// d >= |v| cos(halfAngle), squared as d^2 >= |v|^2 cos^2
+static inline bool inCone(float px, float py, float pz, const Vec3& apex, const Vec3& axis,
+                          float rangeSq, float cosSq) {
+    float vx = px - apex.x, vy = py - apex.y, vz = pz - apex.z;
+    float d = vx * axis.x + vy * axis.y + vz * axis.z;
+    float lengthSq = vx*vx + vy*vy + vz*vz;
+    return d >= 0.0f && lengthSq <= rangeSq && d * d >= lengthSq * cosSq;
+}
+
+static inline bool inCapsule(float px, float py, float pz, const Vec3& a, const Vec3& ab,
+                             float invLengthSq, float radiusSq) {
+    float vx = px - a.x, vy = py - a.y, vz = pz - a.z;
+    float t = std::min(1.0f, std::max(0.0f, (vx * ab.x + vy * ab.y + vz * ab.z) * invLengthSq));
+    float dx = vx - ab.x * t, dy = vy - ab.y * t, dz = vz - ab.z * t;
+    return dx*dx + dy*dy + dz*dz <= radiusSq;
+}
+
+int sphereHitMask(const float* x, const float* y, const float* z, int count,
+                  const Vec3& centre, float radius, uint8_t* mask) {
+    float radiusSq = radius * radius;
+    int hits = 0;
+    int i = 0;
+
+#if DC_HIT_SIMD
+    Float4 cx = splat4(centre.x), cy = splat4(centre.y), cz = splat4(centre.z);
+    Float4 r2 = splat4(radiusSq);
+    for (; i + 4 <= count; i += 4) {
+        Float4 dx = sub4(load4(x + i), cx);
+        Float4 dy = sub4(load4(y + i), cy);
+        Float4 dz = sub4(load4(z + i), cz);
+        Float4 distSq = add4(add4(mul4(dx, dx), mul4(dy, dy)), mul4(dz, dz));
+        hits += storeMask(bits4(le4(distSq, r2)), mask + i);
+    }
+#endif
+
+    for (; i < count; i++) {
+        mask[i] = inSphere(x[i], y[i], z[i], centre, radiusSq) ? 1 : 0;
+        hits += mask[i];
+    }
+    return hits;
+}
+
+int coneHitMask(const float* x, const float* y, const float* z, int count,
+                const Vec3& apex, const Vec3& axis, float range, float halfAngle, uint8_t* mask) {
+    float rangeSq = range * range;
+    float cosine = std::cos(std::min(halfAngle, 1.57079633f));
+    float cosSq = cosine * cosine;
+    int hits = 0;
+    int i = 0;
+
+#if DC_HIT_SIMD
+    Float4 ax = splat4(apex.x), ay = splat4(apex.y), az = splat4(apex.z);
+    Float4 nx = splat4(axis.x), ny = splat4(axis.y), nz = splat4(axis.z);
+    Float4 r2 = splat4(rangeSq), c2 = splat4(cosSq), zero = splat4(0.0f);
+    for (; i + 4 <= count; i += 4) {
+        Float4 vx = sub4(load4(x + i), ax);
+        Float4 vy = sub4(load4(y + i), ay);
+        Float4 vz = sub4(load4(z + i), az);
+        Float4 d = add4(add4(mul4(vx, nx), mul4(vy, ny)), mul4(vz, nz));
+        Float4 lengthSq = add4(add4(mul4(vx, vx), mul4(vy, vy)), mul4(vz, vz));
+        Float4 inside = and4(and4(le4(zero, d), le4(lengthSq, r2)), le4(mul4(lengthSq, c2), mul4(d, d)));
+        hits += storeMask(bits4(inside), mask + i);
+    }
+#endif
+
+    for (; i < count; i++) {
+        mask[i] = inCone(x[i], y[i], z[i], apex, axis, rangeSq, cosSq) ? 1 : 0;
+        hits += mask[i];
+    }
+    return hits;
+}
+
+int capsuleHitMask(const float* x, const float* y, const float* z, int count,
+                   const Vec3& a, const Vec3& b, float radius, uint8_t* mask) {
+    Vec3 ab = b - a;
+    float lengthSq = ab.x * ab.x + ab.y * ab.y + ab.z * ab.z;
+    float invLengthSq = lengthSq > 0.0f ? 1.0f / lengthSq : 0.0f;  // Degenerate: a sphere at a
+    float radiusSq = radius * radius;
+    int hits = 0;
+    int i = 0;
+
+#if DC_HIT_SIMD
+    Float4 ax = splat4(a.x), ay = splat4(a.y), az = splat4(a.z);
+    Float4 bx = splat4(ab.x), by = splat4(ab.y), bz = splat4(ab.z);
+    Float4 inv = splat4(invLengthSq), r2 = splat4(radiusSq);
+    Float4 zero = splat4(0.0f), one = splat4(1.0f);
+    for (; i + 4 <= count; i += 4) {
+        Float4 vx = sub4(load4(x + i), ax);
+        Float4 vy = sub4(load4(y + i), ay);
+        Float4 vz = sub4(load4(z + i), az);
+        Float4 t = mul4(add4(add4(mul4(vx, bx), mul4(vy, by)), mul4(vz, bz)), inv);
+        t = min4(one, max4(zero, t));
+        Float4 dx = sub4(vx, mul4(bx, t));
+        Float4 dy = sub4(vy, mul4(by, t));
+        Float4 dz = sub4(vz, mul4(bz, t));
+        Float4 distSq = add4(add4(mul4(dx, dx), mul4(dy, dy)), mul4(dz, dz));
+        hits += storeMask(bits4(le4(distSq, r2)), mask + i);
+    }
+#endif
+
+    for (; i < count; i++) {
+        mask[i] = inCapsule(x[i], y[i], z[i], a, ab, invLengthSq, radiusSq) ? 1 : 0;
+        hits += mask[i];
+    }
+    return hits;
+}
+
+const char* hitTestBackend() {
+#if defined(__wasm_simd128__)
+    return "wasm-simd128";
+#elif DC_HIT_SIMD
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,173 @@
+#include "job_system.h"
+#include <algorithm>
+
+// Queue owned by the current thread; threads the scheduler did not create
+// (the main loop) share queue 0
+static thread_local int t_queueIndex = 0;
+
+JobSystem::JobSystem(int workerCount)
+    : running_(true)
+    , queuedJobs_(0)
+    , jobsRun_(0)
+    , jobsStolen_(0)
+    , parallelFors_(0)
+{
+#if DC_JOB_THREADS
+    if (workerCount < 0) {
+        workerCount = static_cast<int>(std::thread::hardware_concurrency()) - 1;
+    }
+    workerCount = std::max(0, std::min(workerCount, DC_MAX_JOB_WORKERS));
+#else
+    workerCount = 0;
+#endif
+
+    for (int i = 0; i <= workerCount; i++) {
+        queues_.push_back(std::unique_ptr<WorkerQueue>(new WorkerQueue()));
+    }
+
+#if DC_JOB_THREADS
+    for (int i = 1; i <= workerCount; i++) {
+        threads_.emplace_back(&JobSystem::workerLoop, this, i);
+    }
+#endif
+}
+
+JobSystem::~JobSystem() {
+#if DC_JOB_THREADS
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        running_ = false;
+    }
+    wake_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+#else
+    running_ = false;
+#endif
+}
+
+void JobSystem::run(const std::function<void()>& job, JobCounter* counter) {
+#if DC_JOB_THREADS
+    if (counter) counter->pending++;
+    
+    int index = t_queueIndex;
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->jobs.push_back(Job{job, counter, index});
+    }
+    
+    // Counted under the sleep lock so a worker cannot miss it between
+    // checking for work and going to sleep
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        queuedJobs_++;
+    }
+    wake_.notify_one();
+#else
+    (void)counter;
+    job();
+    jobsRun_++;
+#endif
+}
+
+bool JobSystem::runOne(int queueIndex) {
+    Job job;
+    bool found = false;
+    
+    // Newest local job first (its data is likely still in cache)...
+    {
+        WorkerQueue& own = *queues_[queueIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.jobs.empty()) {
+            job = std::move(own.jobs.back());
+            own.jobs.pop_back();
+            found = true;
+        }
+    }
+    
+    // ...otherwise the oldest job of another thread
+    int count = static_cast<int>(queues_.size());
+    for (int i = 1; i < count && !found; i++) {
+        WorkerQueue& victim = *queues_[(queueIndex + i) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.jobs.empty()) {
+            job = std::move(victim.jobs.front());
+            victim.jobs.pop_front();
+            found = true;
+        }
+    }
+    
+    if (!found) return false;
+    
+    queuedJobs_--;
+    job.fn();
+    jobsRun_++;
+    if (job.owner != queueIndex) jobsStolen_++;
+    if (job.counter) job.counter->pending--;
+    return true;
+}
+
+void JobSystem::wait(JobCounter& counter) {
+#if DC_JOB_THREADS
+    while (counter.pending.load() > 0) {
+        if (!runOne(t_queueIndex)) {
+            std::this_thread::yield();
+        }
+    }
+#else
+    (void)counter;
+#endif
+}
+
+void JobSystem::workerLoop(int queueIndex) {
+#if DC_JOB_THREADS
+    t_queueIndex = queueIndex;
+    while (running_) {
+        if (runOne(queueIndex)) continue;
+        
+        // Idle workers sleep until run() queues something
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [this] {
+            return queuedJobs_.load() > 0 || !running_;
+        });
+    }
+#else
+    (void)queueIndex;
+#endif
+}
+
+void JobSystem::parallelFor(int count, int grainSize, const std::function<void(int begin, int end)>& body) {
+    if (count <= 0) return;
+    parallelFors_++;
+    
+    grainSize = std::max(1, grainSize);
+    int threads = static_cast<int>(queues_.size());
+    if (threads == 1 || count <= grainSize) {
+        body(0, count);
+        return;
+    }
+    
+    // A few ranges per thread so stealing can even out uneven work
+    int ranges = std::min((count + grainSize - 1) / grainSize, threads * 4);
+    int step = (count + ranges - 1) / ranges;
+    
+    JobCounter counter;
+    for (int begin = step; begin < count; begin += step) {
+        int end = std::min(count, begin + step);
+        run([&body, begin, end] { body(begin, end); }, &counter);
+    }
+    
+    // The caller takes the first range itself, then helps with the rest
+    body(0, std::min(count, step));
+    wait(counter);
+}
+
+JobStats JobSystem::getStats() const {
+    JobStats stats;
+    stats.threads = static_cast<int>(queues_.size());
+    stats.jobsRun = jobsRun_.load();
+    stats.jobsStolen = jobsStolen_.load();
+    stats.parallelFors = parallelFors_.load();
+    return stats;
+}
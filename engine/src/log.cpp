@@ -0,0 +1,56 @@
+#include "log.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+
+// 256 lines of up to 159 characters, plus the drained copy: ~80 KB, allocated once
+static const int LOG_LINES = 256;
+static const int LOG_LINE_SIZE = 160;
+
+static char g_lines[LOG_LINES][LOG_LINE_SIZE];
+static char g_levels[LOG_LINES];
+static char g_drained[LOG_LINES * (LOG_LINE_SIZE + 1) + 1];
+static int g_head = 0;      // Next line written
+static int g_count = 0;
+static int g_dropped = 0;
+static std::mutex g_mutex;  // Job threads may log too
+
+void logWrite(int level, const char* format, ...) {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    
+    va_list args;
+    va_start(args, format);
+    vsnprintf(g_lines[g_head], LOG_LINE_SIZE, format, args);
+    va_end(args);
+    g_levels[g_head] = static_cast<char>('0' + level);
+    
+    g_head = (g_head + 1) % LOG_LINES;
+    if (g_count < LOG_LINES) {
+        g_count++;
+    } else {
+        g_dropped++;
+    }
+}
+
+const char* logDrain() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    
+    char* out = g_drained;
+    int first = (g_head - g_count + LOG_LINES) % LOG_LINES;
+    for (int i = 0; i < g_count; i++) {
+        int line = (first + i) % LOG_LINES;
+        size_t length = std::strlen(g_lines[line]);
+        *out++ = g_levels[line];
+        std::memcpy(out, g_lines[line], length);
+        out += length;
+        *out++ = '\n';
+    }
+    *out = '\0';
+    g_count = 0;
+    return g_drained;
+}
+
+int logDroppedCount() {
+    return g_dropped;
+}
@@ -5,6 +5,12 @@
 #include "combat.h"
 #include "entity.h"
 #include "dragon_game.h"
+#include "job_system.h"
+#include "population.h"
+#include "flow_field.h"
+#include "pathfinder.h"
+#include "projectile_pool.h"
+#include "log.h"
 
 #ifdef __EMSCRIPTEN__
 #include <emscripten/emscripten.h>
@@ -19,11 +25,18 @@ struct GameState {
     CombatComponent* playerCombat = nullptr;
     EntityManager* entities = nullptr;
     DragonGameManager* dragonGame = nullptr; // NEW: Dragon gameplay systems
-    std::vector<Projectile*> projectiles;
+    JobSystem* jobs = nullptr; // Worker threads shared by terrain and entities
+    PopulationManager* population = nullptr; // Spawns/despawns enemies with chunks
+    FlowField* chaseField = nullptr; // Paths towards the player for chasing enemies
+    HierarchicalPathfinder* pathfinder = nullptr; // Patrol routes over the loaded chunks
+    ProjectilePool* projectiles = nullptr; // Pooled arrows and staff bolts
+    std::vector<ProjectileHit> projectileHits; // Hits of the last projectile update
+    CombatEventBuffer* combatEvents = nullptr; // This tick's hits/kills/shots, read by JS
     InputState input = {false, false, false, false, false, false};
     bool attackPressed = false;
     bool flyMode = false;
     float lastTime = 0;
+    Vec3 lastPlayerPos;
     float cameraYaw = 0.0f;
     float cameraPitch = 0.0f;
     int chunksLoaded = 0;
@@ -32,30 +45,48 @@ struct GameState {
 
 static GameState g_game;
 
+static const float STAFF_SPLASH_RADIUS = 3.0f; // Staff bolts also hit everything this close to the impact
+
+// Records a hit on an entity, and its death when this hit was the lethal
+// one (as reported by damageEntity, so a kill is recorded only once even
+// when several hits land on the same entity in one tick)
+static void recordHit(EntityHandle target, float damage, const Vec3& position, bool killed) {
+    if (!g_game.combatEvents) return;
+    g_game.combatEvents->push(CombatEventType::HIT, target.slot, target.generation, damage, position);
+    
+    int index = g_game.entities->indexOf(target);
+    if (killed && index >= 0) {
+        g_game.combatEvents->push(CombatEventType::KILL, target.slot, target.generation, damage,
+                                  g_game.entities->getPosition(index));
+    }
+}
+
 extern "C" {
 
 // Initialize the game - 3D chunk-based infinite world
 void init_game(int width, int height) {
-    emscripten_run_script("console.log('[C++] 🔧 Initializing infinite 3D world with chunk streaming...')");
+    DC_LOG_INFO("[C++] 🔧 Initializing infinite 3D world with chunk streaming...");
     
     g_game.renderer = new Renderer();
     bool rendererOk = g_game.renderer->initialize(width, height);
     if (!rendererOk) {
-        emscripten_run_script("console.error('[C++] ❌ Renderer initialization FAILED!')");
+        DC_LOG_ERROR("[C++] ❌ Renderer initialization FAILED!");
         return;
     }
-    emscripten_run_script("console.log('[C++] ✅ Renderer initialized')");
+    DC_LOG_INFO("[C++] ✅ Renderer initialized");
     
     g_game.camera = new Camera();
     // Set initial camera position for 3D third-person view (higher and farther for open world)
     g_game.camera->setPosition(Vec3(0, 35, -45));
     g_game.camera->setTarget(Vec3(0, 10, 0));
-    emscripten_run_script("console.log('[C++] ✅ 3D Camera created')");
+    DC_LOG_INFO("[C++] ✅ 3D Camera created");
     
     // Create chunk-based terrain (optimized for mobile - smaller chunks, close render distance)
+    g_game.jobs = new JobSystem();
     g_game.terrain = new ChunkTerrain(12, 20, 4);
-    emscripten_run_script("console.log('[C++] ✅ Chunk terrain created (mobile optimized)')");
-    emscripten_run_script("console.log('[C++] 📦 Chunk: 12x12 blocks, Load: 4 chunks, Render: 2 chunks only')");
+    g_game.terrain->setJobSystem(g_game.jobs);
+    DC_LOG_INFO("[C++] ✅ Chunk terrain created (mobile optimized)");
+    DC_LOG_INFO("[C++] 📦 Chunk: 12x12 blocks, Load: 4 chunks, Render: 2 chunks only");
     
     g_game.player = new PlayerController(*g_game.terrain);
     
@@ -64,24 +95,31 @@ void init_game(int width, int height) {
     float spawnZ = 0.0f;
     float groundY = g_game.terrain->getHeightAt(spawnX, spawnZ);
     g_game.player->setPosition(Vec3(spawnX, groundY + 2.0f, spawnZ));
-    emscripten_run_script(("console.log('[C++] ✅ Player spawned at: " + 
-                          std::to_string(spawnX) + ", " + 
-                          std::to_string(groundY + 2.0f) + ", " + 
-                          std::to_string(spawnZ) + "')").c_str());
+    g_game.lastPlayerPos = g_game.player->getPosition();
+    DC_LOG_INFO("[C++] ✅ Player spawned at: %f, %f, %f", spawnX, groundY + 2.0f, spawnZ);
     
     // Initialize combat system
     g_game.playerCombat = new CombatComponent(100.0f);
     g_game.playerCombat->setWeapon(WeaponType::SWORD);
-    emscripten_run_script("console.log('[C++] ⚔️ Combat system initialized')");
+    DC_LOG_INFO("[C++] ⚔️ Combat system initialized");
     
     // Initialize entity manager
     g_game.entities = new EntityManager();
+    g_game.entities->setTerrain(g_game.terrain);
+    g_game.entities->setJobSystem(g_game.jobs);
+    g_game.population = new PopulationManager(*g_game.entities, *g_game.terrain);
+    g_game.chaseField = new FlowField(32);
+    g_game.entities->setFlowField(g_game.chaseField);
+    g_game.pathfinder = new HierarchicalPathfinder(*g_game.terrain);
+    g_game.entities->setPathfinder(g_game.pathfinder);
+    g_game.projectiles = new ProjectilePool(256);
+    g_game.combatEvents = new CombatEventBuffer(256);
     
     // Initialize dragon game systems (breeding, hatching, battle, training)
     g_game.dragonGame = new DragonGameManager();
-    emscripten_run_script("console.log('[C++] 🐉 Dragon Game Systems initialized - Breed, Hatch, Battle, Train!')");
+    DC_LOG_INFO("[C++] 🐉 Dragon Game Systems initialized - Breed, Hatch, Battle, Train!");
     
-    emscripten_run_script("console.log('[C++] 🌍 Optimized 3D World ready - Smooth performance on mobile & desktop!')");
+    DC_LOG_INFO("[C++] 🌍 Optimized 3D World ready - Smooth performance on mobile & desktop!");
 }
 
 // Update game logic
@@ -91,6 +129,11 @@ void update_game(float currentTime) {
     
     if (deltaTime > 0.1f) deltaTime = 0.016f; // Cap delta time
     
+    // Events are per tick: JS reads them after update_game returns
+    if (g_game.combatEvents) {
+        g_game.combatEvents->clear();
+    }
+    
     // Update player combat
     g_game.playerCombat->update(deltaTime);
     
@@ -98,9 +141,20 @@ void update_game(float currentTime) {
     g_game.player->update(deltaTime, g_game.input);
     Vec3 playerPos = g_game.player->getPosition();
     
-    // Update chunk terrain based on player position (stream chunks)
+    // Update chunk terrain based on player position (stream chunks, prefetching
+    // along the player's movement and view direction)
     if (g_game.terrain) {
-        g_game.terrain->update(playerPos);
+        Vec3 playerVelocity;
+        if (deltaTime > 0.0f) {
+            playerVelocity = (playerPos - g_game.lastPlayerPos) * (1.0f / deltaTime);
+        }
+        g_game.terrain->update(playerPos, playerVelocity, g_game.camera->getForward());
+    }
+    g_game.lastPlayerPos = playerPos;
+    
+    // Rebuild the chase field when the player enters another block
+    if (g_game.chaseField && g_game.terrain) {
+        g_game.chaseField->update(*g_game.terrain, playerPos);
     }
     
     // Update entities with player position for AI
@@ -108,14 +162,18 @@ void update_game(float currentTime) {
         g_game.entities->update(deltaTime, playerPos);
     }
     
-    // Update projectiles
-    for (auto it = g_game.projectiles.begin(); it != g_game.projectiles.end();) {
-        (*it)->update(deltaTime);
-        if (!(*it)->isActive()) {
-            delete *it;
-            it = g_game.projectiles.erase(it);
-        } else {
-            ++it;
+    // Kills free room under the population cap for chunks still waiting
+    if (g_game.population) {
+        g_game.population->update();
+    }
+    
+    // Update projectiles: swept against entities and terrain along this
+    // frame's travel, hits applied
+    if (g_game.projectiles && g_game.entities) {
+        g_game.projectileHits.clear();
+        g_game.projectiles->update(deltaTime, *g_game.entities, g_game.terrain, &g_game.projectileHits);
+        for (const ProjectileHit& hit : g_game.projectileHits) {
+            recordHit(hit.target, hit.damage, hit.position, hit.killed);
         }
     }
     
@@ -128,44 +186,27 @@ void update_game(float currentTime) {
         
         // Melee attack - check for nearby entities
         if (!g_game.playerCombat->isRangedWeapon()) {
-            Entity* target = g_game.entities->getEntityInRange(
+            EntityHandle target = g_game.entities->getEntityInRange(
                 playerPos,
                 g_game.playerCombat->getAttackRange(),
                 EntityType::PLAYER
             );
             
-            if (target) {
-                target->getCombat().takeDamage(g_game.playerCombat->getAttackDamage());
-                emscripten_run_script("console.log('[C++] ⚔️ Hit enemy!')");
+            if (!target.isNull()) {
+                float damage = g_game.playerCombat->getAttackDamage();
+                bool killed;
+                g_game.entities->damageEntity(target, damage, &killed);
+                recordHit(target, damage, g_game.entities->getPosition(g_game.entities->indexOf(target)), killed);
             }
         } else {
             // Ranged attack - create projectile
             Vec3 cameraDir = g_game.camera->getForward();
-            Projectile* proj = new Projectile(
-                Vec3(playerPos.x, playerPos.y + 1.5f, playerPos.z),
-                cameraDir,
-                g_game.playerCombat->getAttackDamage(),
-                20.0f
-            );
-            g_game.projectiles.push_back(proj);
-            emscripten_run_script("console.log('[C++] 🏹 Fired projectile!')");
-        }
-    }
-    
-    // Check projectile collisions with entities
-    for (Projectile* proj : g_game.projectiles) {
-        if (!proj->isActive()) continue;
-        
-        Entity* hit = g_game.entities->getEntityInRange(
-            proj->getPosition(),
-            0.5f,
-            EntityType::PLAYER
-        );
-        
-        if (hit) {
-            hit->getCombat().takeDamage(proj->getDamage());
-            proj->deactivate();
-            emscripten_run_script("console.log('[C++] 💥 Projectile hit!')");
+            Vec3 origin(playerPos.x, playerPos.y + 1.5f, playerPos.z);
+            float damage = g_game.playerCombat->getAttackDamage();
+            float splash = g_game.playerCombat->getWeapon() == WeaponType::STAFF ? STAFF_SPLASH_RADIUS : 0.0f;
+            if (g_game.projectiles->spawn(origin, cameraDir, 20.0f, damage, splash)) {
+                g_game.combatEvents->push(CombatEventType::PROJECTILE_SPAWN, 0, 0, damage, origin);
+            }
         }
     }
     
@@ -184,13 +225,13 @@ void update_game(float currentTime) {
 // Render game
 void render_game() {
     if (!g_game.renderer) {
-        emscripten_run_script("console.error('[C++] ❌ render_game: No renderer!')");
+        DC_LOG_ERROR("[C++] ❌ render_game: No renderer!");
         return;
     }
     
     static int frameCount = 0;
     if (frameCount == 0) {
-        emscripten_run_script("console.log('[C++] 🎬 First render_game() call')");
+        DC_LOG_INFO("[C++] 🎬 First render_game() call");
     }
     frameCount++;
     
@@ -224,9 +265,9 @@ void render_game() {
         g_game.entities->render(*g_game.renderer);
     }
     
-    // Render projectiles
-    for (Projectile* proj : g_game.projectiles) {
-        proj->render(*g_game.renderer);
+    // Render projectiles (one instanced draw)
+    if (g_game.projectiles) {
+        g_game.projectiles->render(*g_game.renderer);
     }
     
     // Render player
@@ -303,6 +344,149 @@ int get_entity_count() {
     return g_game.entities ? g_game.entities->getEntityCount() : 0;
 }
 
+// Entities per AI level of detail (full rate, reduced rate, sleeping)
+int get_ai_full_count() {
+    return g_game.entities ? g_game.entities->getAILodStats().full : 0;
+}
+
+int get_ai_reduced_count() {
+    return g_game.entities ? g_game.entities->getAILodStats().reduced : 0;
+}
+
+int get_ai_sleeping_count() {
+    return g_game.entities ? g_game.entities->getAILodStats().sleeping : 0;
+}
+
+// Chunk-bound enemy population: alive in loaded chunks, unloaded chunks remembered
+int get_population_count() {
+    return g_game.population ? g_game.population->getStats().live : 0;
+}
+
+int get_population_saved_chunks() {
+    return g_game.population ? g_game.population->getStats().savedChunks : 0;
+}
+
+// Time of the last chase flow field rebuild
+double get_flow_field_build_micros() {
+    return g_game.chaseField ? g_game.chaseField->getBuildMicros() : 0.0;
+}
+
+// Patrol pathfinding: portals in the chunk graph, time of the last chunk update
+int get_path_portal_count() {
+    return g_game.pathfinder ? g_game.pathfinder->getStats().portals : 0;
+}
+
+double get_path_rebuild_micros() {
+    return g_game.pathfinder ? g_game.pathfinder->getStats().rebuildMicros : 0.0;
+}
+
+// Combat events of the last update_game: pointer to count events of 28 bytes
+// (see CombatEvent), valid until the next update_game
+const CombatEvent* get_combat_events() {
+    return g_game.combatEvents ? g_game.combatEvents->data() : nullptr;
+}
+
+int get_combat_event_count() {
+    return g_game.combatEvents ? g_game.combatEvents->getCount() : 0;
+}
+
+int get_combat_events_dropped() {
+    return g_game.combatEvents ? g_game.combatEvents->getDropped() : 0;
+}
+
+// Engine log since the last call, one "<level digit><text>" per line
+// (0 debug .. 3 error); always empty in release builds
+const char* drain_log() {
+    return logDrain();
+}
+
+int get_log_dropped() {
+    return logDroppedCount();
+}
+
+// Projectiles in flight and spawns refused because the pool was full
+int get_projectile_count() {
+    return g_game.projectiles ? g_game.projectiles->getCount() : 0;
+}
+
+int get_projectiles_dropped() {
+    return g_game.projectiles ? g_game.projectiles->getStats().dropped : 0;
+}
+
+// Job system: threads (1 without pthreads), jobs run, jobs stolen by another thread
+int get_job_thread_count() {
+    return g_game.jobs ? g_game.jobs->getStats().threads : 0;
+}
+
+double get_jobs_run() {
+    return g_game.jobs ? static_cast<double>(g_game.jobs->getStats().jobsRun) : 0.0;
+}
+
+double get_jobs_stolen() {
+    return g_game.jobs ? static_cast<double>(g_game.jobs->getStats().jobsStolen) : 0.0;
+}
+
+// Persist evicted chunks to region files under this directory
+// (mount IDBFS/OPFS there from JS before calling)
+void enable_chunk_cache(const char* directory) {
+    if (g_game.terrain && directory) {
+        g_game.terrain->setRegionDirectory(directory);
+    }
+}
+
+// Chunk prefetch lookahead (seconds) and memory cap for prefetching (MB)
+void set_chunk_prefetch(float lookaheadSeconds, int budgetMB) {
+    if (g_game.terrain) {
+        g_game.terrain->setPrefetch(lookaheadSeconds, static_cast<size_t>(budgetMB) * 1024 * 1024);
+    }
+}
+
+// Memory budget for active chunks (MB); JS picks it from navigator.deviceMemory
+void set_chunk_memory_budget(int budgetMB) {
+    if (g_game.terrain) {
+        g_game.terrain->setMemoryBudget(static_cast<size_t>(budgetMB) * 1024 * 1024);
+    }
+}
+
+int get_chunk_resident_bytes() {
+    return g_game.terrain ? static_cast<int>(g_game.terrain->getCacheStats().residentBytes) : 0;
+}
+
+int get_chunk_evictions() {
+    return g_game.terrain ? g_game.terrain->getCacheStats().evictions : 0;
+}
+
+// Edit terrain in block coordinates (world position / 2); block 0 removes
+bool set_terrain_block(int x, int y, int z, int block) {
+    if (!g_game.terrain) return false;
+    return g_game.terrain->setBlock(x, y, z, static_cast<TerrainBlock>(block));
+}
+
+// Chunk cache figures for the debug overlay
+int get_hot_chunk_count() {
+    return g_game.terrain ? g_game.terrain->getCacheStats().hotChunks : 0;
+}
+
+int get_cold_chunk_count() {
+    return g_game.terrain ? g_game.terrain->getCacheStats().coldChunks : 0;
+}
+
+// Raw voxel bytes of one active chunk, for comparison with cold bytes per chunk
+int get_hot_chunk_bytes() {
+    return g_game.terrain ? static_cast<int>(g_game.terrain->getCacheStats().hotBytesPerChunk) : 0;
+}
+
+int get_cold_chunk_bytes() {
+    return g_game.terrain ? static_cast<int>(g_game.terrain->getCacheStats().coldBytes) : 0;
+}
+
+// Average time to restore a chunk from the cold tier (microseconds)
+float get_chunk_decode_micros() {
+    if (!g_game.terrain) return 0.0f;
+    const ChunkCacheStats& stats = g_game.terrain->getCacheStats();
+    return stats.coldHits > 0 ? static_cast<float>(stats.decodeMicros / stats.coldHits) : 0.0f;
+}
+
 // Get player position
 void get_player_position(float* outX, float* outY, float* outZ) {
     Vec3 pos = g_game.player->getPosition();
@@ -315,13 +499,18 @@ void get_player_position(float* outX, float* outY, float* outZ) {
 void cleanup_game() {
     delete g_game.dragonGame;
     delete g_game.playerCombat;
+    delete g_game.population;
     delete g_game.entities;
-    for (Projectile* proj : g_game.projectiles) {
-        delete proj;
-    }
-    g_game.projectiles.clear();
+    delete g_game.chaseField;
+    delete g_game.pathfinder;
+    delete g_game.projectiles;
+    delete g_game.combatEvents;
     delete g_game.player;
+    if (g_game.terrain) {
+        g_game.terrain->flushRegions();
+    }
     delete g_game.terrain;
+    delete g_game.jobs;
     delete g_game.camera;
     delete g_game.renderer;
 }
@@ -0,0 +1,365 @@
+#include "pathfinder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+static const float INF = std::numeric_limits<float>::max();
+
+// Sides: 0 = -X, 1 = +X, 2 = -Z, 3 = +Z
+static const int SIDE_X[4] = {-1, 1, 0, 0};
+static const int SIDE_Z[4] = {0, 0, -1, 1};
+
+// Stretches of open border at least this long get a portal at each end
+static const int LONG_PORTAL_RUN = 6;
+
+static int floorDiv(int a, int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+HierarchicalPathfinder::HierarchicalPathfinder(ChunkTerrain& terrain)
+    : terrain_(terrain)
+    , chunkSize_(terrain.getChunkSize())
+    , stats_{0, 0, 0, 0}
+{
+    terrain_.addChunkListener(this);
+}
+
+HierarchicalPathfinder::~HierarchicalPathfinder() {
+    terrain_.removeChunkListener(this);
+}
+
+// Same weights as the chase flow field, heights in blocks
+float HierarchicalPathfinder::stepCost(int fromHeight, int toHeight, float toCost) {
+    if (toCost < 0.0f) return INF;
+    float step = static_cast<float>(toHeight - fromHeight);
+    float slope = step > 0.0f ? 1.0f + step * step * 2.0f : 1.0f - step * 0.5f;
+    return toCost * slope;
+}
+
+int HierarchicalPathfinder::borderCell(int side, int offset) const {
+    switch (side) {
+        case 0: return offset * chunkSize_;
+        case 1: return offset * chunkSize_ + chunkSize_ - 1;
+        case 2: return offset;
+        default: return (chunkSize_ - 1) * chunkSize_ + offset;
+    }
+}
+
+// Dijkstra over the blocks of one chunk (4-neighbourhood). With reverse set,
+// dist is the cost of reaching startCell from each cell instead.
+void HierarchicalPathfinder::localSearch(const ChunkGraph& graph, int startCell, bool reverse,
+                                         std::vector<float>& dist, std::vector<int>* parent) const {
+    int cells = chunkSize_ * chunkSize_;
+    dist.assign(cells, INF);
+    if (parent) parent->assign(cells, -1);
+    
+    typedef std::pair<float, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    dist[startCell] = 0.0f;
+    open.push({0.0f, startCell});
+    
+    while (!open.empty()) {
+        Entry entry = open.top();
+        open.pop();
+        int cell = entry.second;
+        if (entry.first > dist[cell]) continue;
+        
+        int x = cell % chunkSize_, z = cell / chunkSize_;
+        for (int side = 0; side < 4; side++) {
+            int nx = x + SIDE_X[side], nz = z + SIDE_Z[side];
+            if (nx < 0 || nz < 0 || nx >= chunkSize_ || nz >= chunkSize_) continue;
+            
+            int next = nz * chunkSize_ + nx;
+            float cost = reverse ? stepCost(graph.heights[next], graph.heights[cell], graph.costs[cell])
+                                 : stepCost(graph.heights[cell], graph.heights[next], graph.costs[next]);
+            if (cost == INF) continue;
+            
+            float d = dist[cell] + cost;
+            if (d < dist[next]) {
+                dist[next] = d;
+                if (parent) (*parent)[next] = cell;
+                open.push({d, next});
+            }
+        }
+    }
+}
+
+// Appends the blocks after fromCell up to toCell as world positions
+bool HierarchicalPathfinder::localPath(const ChunkGraph& graph, const ChunkCoord& coord, int fromCell, int toCell,
+                                       std::vector<Vec3>& out) const {
+    if (fromCell == toCell) return true;
+    
+    std::vector<float> dist;
+    std::vector<int> parent;
+    localSearch(graph, fromCell, false, dist, &parent);
+    if (dist[toCell] == INF) return false;
+    
+    size_t first = out.size();
+    for (int cell = toCell; cell != fromCell; cell = parent[cell]) {
+        float x = (coord.x * chunkSize_ + cell % chunkSize_) * 2.0f;
+        float z = (coord.z * chunkSize_ + cell / chunkSize_) * 2.0f;
+        out.push_back(Vec3(x, graph.heights[cell] * 2.0f, z));
+    }
+    std::reverse(out.begin() + first, out.end());
+    return true;
+}
+
+// Portals for the border between graph (on its side) and neighbour: one in
+// the middle of each open stretch, one at each end of long stretches
+void HierarchicalPathfinder::linkBorder(ChunkGraph& graph, ChunkGraph& neighbour, int side) {
+    int opposite = side ^ 1;
+    auto onSide = [](int s) {
+        return [s](const Portal& p) { return p.side == s; };
+    };
+    graph.portals.erase(std::remove_if(graph.portals.begin(), graph.portals.end(), onSide(side)), graph.portals.end());
+    neighbour.portals.erase(std::remove_if(neighbour.portals.begin(), neighbour.portals.end(), onSide(opposite)),
+                            neighbour.portals.end());
+                            
+    auto addPortal = [&](int offset) {
+        graph.portals.push_back({side, offset, borderCell(side, offset)});
+        neighbour.portals.push_back({opposite, offset, borderCell(opposite, offset)});
+    };
+    
+    int runStart = -1;
+    for (int offset = 0; offset <= chunkSize_; offset++) {
+        bool open = offset < chunkSize_ &&
+                    graph.costs[borderCell(side, offset)] >= 0.0f &&
+                    neighbour.costs[borderCell(opposite, offset)] >= 0.0f;
+        if (open && runStart < 0) {
+            runStart = offset;
+        } else if (!open && runStart >= 0) {
+            int runEnd = offset - 1;
+            if (runEnd - runStart + 1 >= LONG_PORTAL_RUN) {
+                addPortal(runStart);
+                addPortal(runEnd);
+            } else {
+                addPortal((runStart + runEnd) / 2);
+            }
+            runStart = -1;
+        }
+    }
+}
+
+void HierarchicalPathfinder::rebuildPortalCosts(ChunkGraph& graph) {
+    int count = static_cast<int>(graph.portals.size());
+    graph.portalCosts.assign(count * count, INF);
+    
+    std::vector<float> dist;
+    for (int from = 0; from < count; from++) {
+        localSearch(graph, graph.portals[from].cell, false, dist, nullptr);
+        for (int to = 0; to < count; to++) {
+            graph.portalCosts[from * count + to] = dist[graph.portals[to].cell];
+        }
+    }
+    stats_.rebuilds++;
+}
+
+void HierarchicalPathfinder::onChunkLoaded(const Chunk& chunk) {
+    auto start = std::chrono::steady_clock::now();
+    
+    ChunkGraph& graph = chunks_[chunk.coord];
+    graph.heights = chunk.heights;
+    graph.costs.resize(chunk.biomes.size());
+    for (size_t i = 0; i < chunk.biomes.size(); i++) {
+        switch (static_cast<BiomeType>(chunk.biomes[i])) {
+            case BiomeType::LAVA: graph.costs[i] = -1.0f; break;
+            case BiomeType::WATER: graph.costs[i] = 4.0f; break;
+            default: graph.costs[i] = 1.0f; break;
+        }
+    }
+    graph.portals.clear();
+    
+    // Only the borders with loaded neighbours change
+    for (int side = 0; side < 4; side++) {
+        auto it = chunks_.find({chunk.coord.x + SIDE_X[side], chunk.coord.z + SIDE_Z[side]});
+        if (it == chunks_.end()) continue;
+        linkBorder(graph, it->second, side);
+        rebuildPortalCosts(it->second);
+    }
+    rebuildPortalCosts(graph);
+    
+    updateStats();
+    stats_.rebuildMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void HierarchicalPathfinder::onChunkUnloaded(const Chunk& chunk) {
+    auto start = std::chrono::steady_clock::now();
+    
+    for (int side = 0; side < 4; side++) {
+        auto it = chunks_.find({chunk.coord.x + SIDE_X[side], chunk.coord.z + SIDE_Z[side]});
+        if (it == chunks_.end()) continue;
+        
+        std::vector<Portal>& portals = it->second.portals;
+        int opposite = side ^ 1;
+        portals.erase(std::remove_if(portals.begin(), portals.end(), [opposite](const Portal& p) {
+            return p.side == opposite;
+        }), portals.end());
+        rebuildPortalCosts(it->second);
+    }
+    chunks_.erase(chunk.coord);
+    
+    updateStats();
+    stats_.rebuildMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+void HierarchicalPathfinder::updateStats() {
+    stats_.chunks = static_cast<int>(chunks_.size());
+    stats_.portals = 0;
+    for (const auto& pair : chunks_) {
+        stats_.portals += static_cast<int>(pair.second.portals.size());
+    }
+}
+
+bool HierarchicalPathfinder::findPath(const Vec3& start, const Vec3& goal, std::vector<Vec3>& out) const {
+    out.clear();
+    
+    int startX = ChunkTerrain::worldToBlock(start.x), startZ = ChunkTerrain::worldToBlock(start.z);
+    int goalX = ChunkTerrain::worldToBlock(goal.x), goalZ = ChunkTerrain::worldToBlock(goal.z);
+    ChunkCoord startChunk = {floorDiv(startX, chunkSize_), floorDiv(startZ, chunkSize_)};
+    ChunkCoord goalChunk = {floorDiv(goalX, chunkSize_), floorDiv(goalZ, chunkSize_)};
+    
+    auto startIt = chunks_.find(startChunk);
+    auto goalIt = chunks_.find(goalChunk);
+    if (startIt == chunks_.end() || goalIt == chunks_.end()) return false;
+    
+    const ChunkGraph& startGraph = startIt->second;
+    const ChunkGraph& goalGraph = goalIt->second;
+    int startCell = (startZ - startChunk.z * chunkSize_) * chunkSize_ + (startX - startChunk.x * chunkSize_);
+    int goalCell = (goalZ - goalChunk.z * chunkSize_) * chunkSize_ + (goalX - goalChunk.x * chunkSize_);
+    if (goalGraph.costs[goalCell] < 0.0f) return false;
+    
+    // Inside one chunk a block search is enough, when it finds a way
+    bool sameChunk = startChunk.x == goalChunk.x && startChunk.z == goalChunk.z;
+    if (sameChunk && localPath(startGraph, startChunk, startCell, goalCell, out)) return true;
+    out.clear();
+    
+    // Start and goal join the abstract graph through the portals of their chunk
+    std::vector<float> fromStart, toGoal;
+    localSearch(startGraph, startCell, false, fromStart, nullptr);
+    localSearch(goalGraph, goalCell, true, toGoal, nullptr);
+    
+    // A* over portals. Node portal -1 is the start, -2 the goal.
+    struct Node {
+        ChunkCoord chunk;
+        int portal;
+        float cost;
+        int parent;
+        bool closed;
+    };
+    std::vector<Node> nodes;
+    std::map<std::pair<ChunkCoord, int>, int> nodeIndex;
+    typedef std::pair<float, int> Entry;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+    
+    auto blockOf = [&](const ChunkCoord& chunk, int cell, int& x, int& z) {
+        x = chunk.x * chunkSize_ + cell % chunkSize_;
+        z = chunk.z * chunkSize_ + cell / chunkSize_;
+    };
+    // Every block step costs at least 1, so the block distance is admissible
+    auto heuristic = [&](const ChunkCoord& chunk, int cell) {
+        int x, z;
+        blockOf(chunk, cell, x, z);
+        return static_cast<float>(std::abs(x - goalX) + std::abs(z - goalZ));
+    };
+    auto relax = [&](const ChunkCoord& chunk, int portal, float cost, int parent, float h) {
+        auto key = std::make_pair(chunk, portal);
+        auto it = nodeIndex.find(key);
+        int index;
+        if (it == nodeIndex.end()) {
+            index = static_cast<int>(nodes.size());
+            nodeIndex[key] = index;
+            nodes.push_back({chunk, portal, INF, -1, false});
+        } else {
+            index = it->second;
+        }
+        if (nodes[index].closed || cost >= nodes[index].cost) return;
+        nodes[index].cost = cost;
+        nodes[index].parent = parent;
+        open.push({cost + h, index});
+    };
+    
+    nodes.push_back({startChunk, -1, 0.0f, -1, false});
+    open.push({0.0f, 0});
+    int goalNode = -1;
+    
+    while (!open.empty()) {
+        int current = open.top().second;
+        open.pop();
+        if (nodes[current].closed) continue;
+        nodes[current].closed = true;
+        
+        Node node = nodes[current];
+        if (node.portal == -2) {
+            goalNode = current;
+            break;
+        }
+        
+        if (node.portal == -1) {
+            for (size_t p = 0; p < startGraph.portals.size(); p++) {
+                float cost = fromStart[startGraph.portals[p].cell];
+                if (cost == INF) continue;
+                relax(startChunk, static_cast<int>(p), cost, current, heuristic(startChunk, startGraph.portals[p].cell));
+            }
+            continue;
+        }
+        
+        const ChunkGraph& graph = chunks_.at(node.chunk);
+        const Portal& portal = graph.portals[node.portal];
+        int count = static_cast<int>(graph.portals.size());
+        
+        // Into the goal from a portal of the goal chunk
+        if (node.chunk.x == goalChunk.x && node.chunk.z == goalChunk.z && toGoal[portal.cell] != INF) {
+            relax(goalChunk, -2, node.cost + toGoal[portal.cell], current, 0.0f);
+        }
+        
+        // Across the chunk to its other portals
+        for (int q = 0; q < count; q++) {
+            float cost = graph.portalCosts[node.portal * count + q];
+            if (q == node.portal || cost == INF) continue;
+            relax(node.chunk, q, node.cost + cost, current, heuristic(node.chunk, graph.portals[q].cell));
+        }
+        
+        // Over the border to the matching portal of the neighbour
+        ChunkCoord next = {node.chunk.x + SIDE_X[portal.side], node.chunk.z + SIDE_Z[portal.side]};
+        auto nextIt = chunks_.find(next);
+        if (nextIt == chunks_.end()) continue;
+        const std::vector<Portal>& nextPortals = nextIt->second.portals;
+        for (size_t q = 0; q < nextPortals.size(); q++) {
+            if (nextPortals[q].side != (portal.side ^ 1) || nextPortals[q].offset != portal.offset) continue;
+            float cost = stepCost(graph.heights[portal.cell], nextIt->second.heights[nextPortals[q].cell],
+                                  nextIt->second.costs[nextPortals[q].cell]);
+            relax(next, static_cast<int>(q), node.cost + cost, current, heuristic(next, nextPortals[q].cell));
+            break;
+        }
+    }
+    
+    if (goalNode < 0) return false;
+    
+    // Refine: block paths inside each chunk, single steps across borders
+    std::vector<int> chain;
+    for (int n = goalNode; n >= 0; n = nodes[n].parent) {
+        chain.push_back(n);
+    }
+    std::reverse(chain.begin(), chain.end());
+    
+    ChunkCoord chunk = startChunk;
+    int cell = startCell;
+    for (size_t k = 1; k < chain.size(); k++) {
+        const Node& node = nodes[chain[k]];
+        int target = node.portal == -2 ? goalCell : chunks_.at(node.chunk).portals[node.portal].cell;
+        
+        if (node.chunk.x == chunk.x && node.chunk.z == chunk.z) {
+            if (!localPath(chunks_.at(chunk), chunk, cell, target, out)) return false;
+        } else {
+            int x, z;
+            blockOf(node.chunk, target, x, z);
+            out.push_back(Vec3(x * 2.0f, chunks_.at(node.chunk).heights[target] * 2.0f, z * 2.0f));
+        }
+        chunk = node.chunk;
+        cell = target;
+    }
+    return true;
+}
@@ -46,42 +46,44 @@ void PlayerController2D::update(float deltaTime, const InputState& input) {
     int tileX = (int)(position_.x / 2.0f);
     int tileY = (int)(position_.y / 2.0f);
     
+    // One palette lookup per probed tile
+    uint8_t below = terrain_.getTileFlags(tileX, tileY - 1);
+    uint8_t here = terrain_.getTileFlags(tileX, tileY);
+    uint8_t above = terrain_.getTileFlags(tileX, tileY + 1);
+    uint8_t right = terrain_.getTileFlags(tileX + 1, tileY);
+    uint8_t left = terrain_.getTileFlags(tileX - 1, tileY);
+    
     // Ground collision
     isGrounded_ = false;
-    if (terrain_.isSolid(tileX, tileY - 1) || terrain_.isPlatform(tileX, tileY - 1)) {
-        if (velocity_.y < 0) {
-            position_.y = (float)(tileY) * 2.0f + 2.0f;
-            velocity_.y = 0;
-            isGrounded_ = true;
-        }
+    if ((below & (TILE_SOLID | TILE_PLATFORM)) && velocity_.y < 0) {
+        position_.y = (float)(tileY) * 2.0f + 2.0f;
+        velocity_.y = 0;
+        isGrounded_ = true;
     }
     
     // Platform collision from below
-    if (terrain_.isPlatform(tileX, tileY) && velocity_.y > 0) {
+    if ((here & TILE_PLATFORM) && velocity_.y > 0) {
         position_.y = (float)(tileY) * 2.0f - 0.1f;
         velocity_.y = 0;
     }
     
     // Ceiling collision
-    if (terrain_.isSolid(tileX, tileY + 1)) {
-        if (velocity_.y > 0) {
-            velocity_.y = 0;
-        }
+    if ((above & TILE_SOLID) && velocity_.y > 0) {
+        velocity_.y = 0;
     }
     
     // Wall collision
-    if (terrain_.isSolid(tileX + 1, tileY) && velocity_.x > 0) {
+    if ((right & TILE_SOLID) && velocity_.x > 0) {
         position_.x = (float)(tileX) * 2.0f + 1.0f;
         velocity_.x = 0;
     }
-    if (terrain_.isSolid(tileX - 1, tileY) && velocity_.x < 0) {
+    if ((left & TILE_SOLID) && velocity_.x < 0) {
         position_.x = (float)(tileX) * 2.0f + 1.0f;
         velocity_.x = 0;
     }
     
     // Keep in bounds
     if (position_.x < 0) position_.x = 0;
-    if (position_.x > terrain_.getWidth() * 2.0f) position_.x = terrain_.getWidth() * 2.0f;
     if (position_.y < 0) {
         position_.y = 0;
         velocity_.y = 0;
@@ -0,0 +1,232 @@
+#include "population.h"
+#include <algorithm>
+
+// xorshift32, state must be non-zero
+static uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static uint32_t chunkSeed(const ChunkCoord& coord, uint32_t seed) {
+    uint32_t h = seed ^ (static_cast<uint32_t>(coord.x) * 73856093u) ^ (static_cast<uint32_t>(coord.z) * 19349663u);
+    h ^= h >> 16;
+    h *= 0x45d9f3bu;
+    h ^= h >> 16;
+    return h ? h : 1u;
+}
+
+PopulationManager::PopulationManager(EntityManager& entities, ChunkTerrain& terrain, uint32_t seed)
+    : entities_(entities)
+    , terrain_(terrain)
+    , seed_(seed)
+    , maxPerChunk_(3)
+    , maxTotal_(120)
+    , maxSavedChunks_(256)
+    , stats_{0, 0, 0, 0, 0}
+{
+    terrain_.addChunkListener(this);
+}
+
+PopulationManager::~PopulationManager() {
+    terrain_.removeChunkListener(this);
+}
+
+// Drops handles of entities that died since the last count
+int PopulationManager::countLive() {
+    int total = 0;
+    for (auto& pair : live_) {
+        std::vector<EntityHandle>& handles = pair.second;
+        handles.erase(std::remove_if(handles.begin(), handles.end(), [this](EntityHandle h) {
+            return !entities_.isValid(h);
+        }), handles.end());
+        total += static_cast<int>(handles.size());
+    }
+    return total;
+}
+
+EntityHandle PopulationManager::spawn(EntityType type, BiomeType biome, const Vec3& position) {
+    if (type == EntityType::ENEMY_GOBLIN) {
+        return entities_.addGoblin(position);
+    }
+    
+    // Dragons take their colour from where they live
+    Color color = biome == BiomeType::LAVA ? Color(0.7f, 0.15f, 0.1f) : Color(0.45f, 0.45f, 0.55f);
+    return entities_.addDragon(type, position, color);
+}
+
+void PopulationManager::spawnFresh(const ChunkCoord& coord, BiomeType biome, int room, std::vector<EntityHandle>& out) {
+    uint32_t rng = chunkSeed(coord, seed_);
+    
+    // Biome decides what lives here: goblins on grass, goblins and the odd
+    // dragon in the mountains, dragons around lava, nothing on water
+    int goblins = 0;
+    int dragons = 0;
+    switch (biome) {
+        case BiomeType::PLAINS:
+            goblins = nextRandom(rng) % 3;
+            break;
+        case BiomeType::MOUNTAINS:
+            goblins = nextRandom(rng) % 2;
+            dragons = nextRandom(rng) % 3 == 0 ? 1 : 0;
+            break;
+        case BiomeType::LAVA:
+            dragons = nextRandom(rng) % 2;
+            break;
+        case BiomeType::WATER:
+            break;
+    }
+    
+    int chunkSize = terrain_.getChunkSize();
+    int count = std::min(std::min(goblins + dragons, maxPerChunk_), room);
+    for (int i = 0; i < count; i++) {
+        float x = (coord.x * chunkSize + static_cast<int>(nextRandom(rng) % chunkSize)) * 2.0f;
+        float z = (coord.z * chunkSize + static_cast<int>(nextRandom(rng) % chunkSize)) * 2.0f;
+        if (terrain_.getBiomeAt(x, z) == BiomeType::WATER) continue;
+        
+        EntityType type = i < dragons ? EntityType::ENEMY_DRAGON : EntityType::ENEMY_GOBLIN;
+        out.push_back(spawn(type, biome, Vec3(x, terrain_.getHeightAt(x, z), z)));
+        stats_.spawned++;
+    }
+}
+
+// Oldest waiting chunks first, while the overall cap allows
+void PopulationManager::populatePending() {
+    int room = maxTotal_ - countLive();
+    while (!pending_.empty()) {
+        PendingChunk& next = pending_.front();
+        std::vector<EntityHandle>& handles = live_[next.coord];
+        size_t before = handles.size();
+        
+        if (next.fresh) {
+            if (room <= 0) break;
+            spawnFresh(next.coord, next.biome, room, handles);
+        } else {
+            size_t count = std::min(next.survivors.size(), static_cast<size_t>(std::max(room, 0)));
+            for (size_t i = 0; i < count; i++) {
+                const SavedEntity& entity = next.survivors[i];
+                EntityHandle handle = spawn(entity.type, next.biome, Vec3(entity.x, entity.y, entity.z));
+                entities_.setHealth(handle, entity.health);
+                handles.push_back(handle);
+                stats_.restored++;
+            }
+            next.survivors.erase(next.survivors.begin(), next.survivors.begin() + count);
+            
+            // The rest come back once there is room
+            if (!next.survivors.empty()) break;
+        }
+        
+        room -= static_cast<int>(handles.size() - before);
+        pending_.pop_front();
+    }
+}
+
+void PopulationManager::update() {
+    if (pending_.empty()) return;
+    
+    stats_.live = countLive();
+    if (stats_.live >= maxTotal_) return;
+    
+    populatePending();
+    stats_.live = countLive();
+}
+
+// Moves every tracked entity to the list of the loaded chunk it stands in.
+// Ones outside the loaded area stay with the chunk they were last in.
+void PopulationManager::rehome() {
+    for (auto& pair : live_) {
+        std::vector<EntityHandle>& handles = pair.second;
+        size_t kept = 0;
+        for (size_t i = 0; i < handles.size(); i++) {
+            int index = entities_.indexOf(handles[i]);
+            if (index < 0) continue;
+            
+            Vec3 pos = entities_.getPosition(index);
+            ChunkCoord coord = terrain_.worldToChunk(pos.x, pos.z);
+            if (coord.x != pair.first.x || coord.z != pair.first.z) {
+                auto home = live_.find(coord);
+                if (home != live_.end()) {
+                    home->second.push_back(handles[i]);
+                    continue;
+                }
+            }
+            handles[kept++] = handles[i];
+        }
+        handles.resize(kept);
+    }
+}
+
+void PopulationManager::onChunkLoaded(const Chunk& chunk) {
+    // Tracked from the start, so enemies walking in are saved with it
+    live_[chunk.coord];
+    
+    PendingChunk pending;
+    pending.coord = chunk.coord;
+    pending.biome = chunk.biome;
+    pending.fresh = true;
+    
+    auto saved = saved_.find(chunk.coord);
+    if (saved != saved_.end()) {
+        // Survivors from the last visit (an empty list keeps a cleared chunk clear)
+        pending.fresh = false;
+        pending.survivors = std::move(saved->second);
+        saved_.erase(saved);
+        savedOrder_.erase(std::find_if(savedOrder_.begin(), savedOrder_.end(), [&](const ChunkCoord& c) {
+            return c.x == chunk.coord.x && c.z == chunk.coord.z;
+        }));
+    }
+    pending_.push_back(std::move(pending));
+    populatePending();
+    
+    stats_.live = countLive();
+    stats_.savedChunks = static_cast<int>(saved_.size());
+}
+
+void PopulationManager::onChunkUnloaded(const Chunk& chunk) {
+    // Enemies go with the chunk they stand in, not the one they spawned in,
+    // so one chasing the player is not removed when its home unloads behind it
+    rehome();
+    
+    std::vector<SavedEntity> survivors;
+    bool populated = true;
+    auto waiting = std::find_if(pending_.begin(), pending_.end(), [&](const PendingChunk& p) {
+        return p.coord.x == chunk.coord.x && p.coord.z == chunk.coord.z;
+    });
+    if (waiting != pending_.end()) {
+        // Survivors still waiting for room are kept as they were
+        populated = !waiting->fresh;
+        survivors = std::move(waiting->survivors);
+        pending_.erase(waiting);
+    }
+    
+    auto it = live_.find(chunk.coord);
+    if (it != live_.end()) {
+        for (EntityHandle handle : it->second) {
+            int index = entities_.indexOf(handle);
+            if (index < 0 || !entities_.isAlive(index)) continue;
+            
+            Vec3 pos = entities_.getPosition(index);
+            survivors.push_back({entities_.getType(index), pos.x, pos.y, pos.z, entities_.getHealth(index)});
+            entities_.despawnEntity(handle);
+            stats_.despawned++;
+        }
+        live_.erase(it);
+    }
+    
+    // Chunks that never got a population and hold nobody have nothing to
+    // remember. Others are saved even when everything in them was killed,
+    // so they stay cleared.
+    if (populated || !survivors.empty()) {
+        saved_[chunk.coord] = survivors;
+        savedOrder_.push_back(chunk.coord);
+        while (static_cast<int>(savedOrder_.size()) > maxSavedChunks_) {
+            saved_.erase(savedOrder_.front());
+            savedOrder_.pop_front();
+        }
+    }
+    populatePending();
+    
+    stats_.live = countLive();
+    stats_.savedChunks = static_cast<int>(saved_.size());
+}
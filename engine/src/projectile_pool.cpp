@@ -0,0 +1,186 @@
+#include "projectile_pool.h"
+#include <algorithm>
+#include <cmath>
+
+// Entities are hit as a sphere around their body (positions are at the feet)
+static const float ENTITY_HIT_HEIGHT = 0.75f;
+static const float ENTITY_HIT_RADIUS = 0.75f;
+
+static const float PROJECTILE_LIFETIME = 5.0f;
+
+ProjectilePool::ProjectilePool(int capacity)
+    : capacity_(capacity > 0 ? capacity : 1)
+    , count_(0)
+    , stats_{0, 0, 0}
+{
+    x_.resize(capacity_);
+    y_.resize(capacity_);
+    z_.resize(capacity_);
+    vx_.resize(capacity_);
+    vy_.resize(capacity_);
+    vz_.resize(capacity_);
+    damage_.resize(capacity_);
+    radius_.resize(capacity_);
+    splash_.resize(capacity_);
+    lifetime_.resize(capacity_);
+    color_.resize(capacity_);
+    
+    rayOrigins_.resize(capacity_);
+    rayDirs_.resize(capacity_);
+    rayLengths_.resize(capacity_);
+    rayHits_.resize(capacity_);
+    expired_.resize(capacity_);
+    instances_.resize(capacity_);
+}
+
+bool ProjectilePool::spawn(const Vec3& position, const Vec3& direction, float speed, float damage,
+                           float splashRadius, float radius, const Color& color) {
+    if (count_ >= capacity_) {
+        stats_.dropped++;
+        return false;
+    }
+    
+    Vec3 dir = direction.normalize();
+    if (dir.length() == 0.0f) dir = Vec3(0, 0, 1);
+    
+    int i = count_++;
+    x_[i] = position.x;
+    y_[i] = position.y;
+    z_[i] = position.z;
+    vx_[i] = dir.x * speed;
+    vy_[i] = dir.y * speed;
+    vz_[i] = dir.z * speed;
+    damage_[i] = damage;
+    radius_[i] = radius;
+    splash_[i] = splashRadius;
+    lifetime_[i] = PROJECTILE_LIFETIME;
+    color_[i] = color;
+    stats_.spawned++;
+    return true;
+}
+
+void ProjectilePool::remove(int index) {
+    int last = --count_;
+    x_[index] = x_[last];
+    y_[index] = y_[last];
+    z_[index] = z_[last];
+    vx_[index] = vx_[last];
+    vy_[index] = vy_[last];
+    vz_[index] = vz_[last];
+    damage_[index] = damage_[last];
+    radius_[index] = radius_[last];
+    splash_[index] = splash_[last];
+    lifetime_[index] = lifetime_[last];
+    color_[index] = color_[last];
+}
+
+// Sphere query around the impact; the directly hit entity is skipped
+void ProjectilePool::splash(int index, const Vec3& impact, EntityHandle direct, EntityManager& entities,
+                            std::vector<ProjectileHit>* hits) {
+    entities.getEntitiesInRange(impact, splash_[index], splashTargets_);
+    float damage = damage_[index] * 0.5f;
+    for (EntityHandle handle : splashTargets_) {
+        if (handle == direct) continue;
+        bool killed;
+        entities.damageEntity(handle, damage, &killed);
+        stats_.hits++;
+        if (hits) hits->push_back({handle, impact, damage, killed});
+    }
+}
+
+void ProjectilePool::update(float deltaTime, EntityManager& entities, const ChunkTerrain* terrain,
+                            std::vector<ProjectileHit>* hits) {
+    if (count_ == 0) return;
+    
+    // This frame's travel, as one batched terrain raycast
+    for (int i = 0; i < count_; i++) {
+        rayOrigins_[i] = Vec3(x_[i], y_[i], z_[i]);
+        rayDirs_[i] = Vec3(vx_[i] * deltaTime, vy_[i] * deltaTime, vz_[i] * deltaTime);
+        rayLengths_[i] = rayDirs_[i].length();
+        rayHits_[i].hit = false;
+    }
+    if (terrain) {
+        terrain->raycastBatch(rayOrigins_.data(), rayDirs_.data(), rayLengths_.data(), count_, rayHits_.data());
+    }
+    
+    for (int i = 0; i < count_; i++) {
+        const Vec3& from = rayOrigins_[i];
+        const Vec3& travel = rayDirs_[i];
+        float length = rayLengths_[i];
+        
+        // Fraction of the travel done before the terrain stops it
+        float limit = 1.0f;
+        if (rayHits_[i].hit) {
+            limit = length > 0.0f ? rayHits_[i].distance / length : 0.0f;
+        }
+        
+        // Entities whose sphere the projectile's sphere touches before that:
+        // first root of |from + travel * t - centre| = r over t in [0, limit]
+        float reach = radius_[i] + ENTITY_HIT_RADIUS;
+        Vec3 to = from + travel;
+        Vec3 minCorner(std::min(from.x, to.x) - reach, std::min(from.y, to.y) - reach - ENTITY_HIT_HEIGHT,
+                       std::min(from.z, to.z) - reach);
+        Vec3 maxCorner(std::max(from.x, to.x) + reach, std::max(from.y, to.y) + reach - ENTITY_HIT_HEIGHT,
+                       std::max(from.z, to.z) + reach);
+        entities.getEntitiesInBox(minCorner, maxCorner, candidates_);
+        
+        EntityHandle target;
+        float targetT = limit;
+        float a = length * length;
+        for (EntityHandle handle : candidates_) {
+            Vec3 centre = entities.getPosition(entities.indexOf(handle));
+            centre.y += ENTITY_HIT_HEIGHT;
+            Vec3 offset = from - centre;
+            float c = offset.x * offset.x + offset.y * offset.y + offset.z * offset.z - reach * reach;
+            
+            float t;
+            if (c <= 0.0f) {
+                t = 0.0f;  // Already touching
+            } else {
+                if (a <= 0.0f) continue;
+                float b = 2.0f * (offset.x * travel.x + offset.y * travel.y + offset.z * travel.z);
+                float disc = b * b - 4.0f * a * c;
+                if (b >= 0.0f || disc < 0.0f) continue;  // Moving away or passing by
+                t = (-b - std::sqrt(disc)) / (2.0f * a);
+            }
+            if (t <= targetT) {
+                targetT = t;
+                target = handle;
+            }
+        }
+        
+        expired_[i] = 0;
+        if (!target.isNull()) {
+            Vec3 impact = from + travel * targetT;
+            bool killed;
+            entities.damageEntity(target, damage_[i], &killed);
+            stats_.hits++;
+            if (hits) hits->push_back({target, impact, damage_[i], killed});
+            if (splash_[i] > 0.0f) splash(i, impact, target, entities, hits);
+            expired_[i] = 1;
+        } else if (rayHits_[i].hit) {
+            if (splash_[i] > 0.0f) splash(i, rayHits_[i].point, EntityHandle(), entities, hits);
+            expired_[i] = 1;
+        } else {
+            x_[i] = to.x;
+            y_[i] = to.y;
+            z_[i] = to.z;
+            lifetime_[i] -= deltaTime;
+            if (lifetime_[i] <= 0.0f) expired_[i] = 1;
+        }
+    }
+    
+    // From the back, so every moved-in projectile was already resolved
+    for (int i = count_ - 1; i >= 0; i--) {
+        if (expired_[i]) remove(i);
+    }
+}
+
+void ProjectilePool::render(Renderer& renderer) {
+    for (int i = 0; i < count_; i++) {
+        instances_[i].position = Vec3(x_[i], y_[i], z_[i]);
+        instances_[i].size = radius_[i] * 2.0f;
+        instances_[i].color = color_[i];
+    }
+    renderer.drawCubeInstances(instances_.data(), count_);
+}
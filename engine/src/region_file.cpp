@@ -0,0 +1,194 @@
+#include "region_file.h"
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char REGION_MAGIC[4] = {'D', 'C', 'R', 'G'};
+static const uint32_t REGION_VERSION = 2; // v2: RLE chunk payloads
+
+static int floorDiv(int a, int b) {
+    return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+// RegionFile implementation
+RegionFile::RegionFile(const std::string& path, int regionSize)
+    : fd_(-1)
+    , regionSize_(regionSize)
+    , fileSize_(0)
+    , mapped_(nullptr)
+    , mappedSize_(0)
+{
+    fd_ = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ >= 0 && !initialize()) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
+
+RegionFile::~RegionFile() {
+    unmapFile();
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool RegionFile::initialize() {
+    size_t tableBytes = sizeof(RegionEntry) * regionSize_ * regionSize_;
+    size_t headerBytes = sizeof(RegionHeader) + tableBytes;
+    entries_.assign(regionSize_ * regionSize_, RegionEntry{0, 0});
+    
+    struct stat st;
+    if (fstat(fd_, &st) != 0) return false;
+    fileSize_ = static_cast<size_t>(st.st_size);
+    
+    // Reuse an existing file only if its header matches this build's layout
+    if (fileSize_ >= headerBytes) {
+        RegionHeader header;
+        if (pread(fd_, &header, sizeof(header), 0) == sizeof(header) &&
+            std::memcmp(header.magic, REGION_MAGIC, 4) == 0 &&
+            header.version == REGION_VERSION &&
+            header.regionSize == static_cast<uint32_t>(regionSize_)) {
+            return pread(fd_, entries_.data(), tableBytes, sizeof(RegionHeader)) ==
+                   static_cast<ssize_t>(tableBytes);
+        }
+    }
+    
+    // Fresh (or stale) file - start over with an empty offset table
+    if (ftruncate(fd_, 0) != 0) return false;
+    
+    RegionHeader header;
+    std::memcpy(header.magic, REGION_MAGIC, 4);
+    header.version = REGION_VERSION;
+    header.regionSize = static_cast<uint32_t>(regionSize_);
+    header.reserved = 0;
+    
+    if (pwrite(fd_, &header, sizeof(header), 0) != sizeof(header)) return false;
+    if (pwrite(fd_, entries_.data(), tableBytes, sizeof(RegionHeader)) !=
+        static_cast<ssize_t>(tableBytes)) return false;
+        
+    fileSize_ = headerBytes;
+    return true;
+}
+
+bool RegionFile::mapFile() {
+    if (mapped_ && mappedSize_ == fileSize_) return true;
+    unmapFile();
+    
+    void* ptr = mmap(nullptr, fileSize_, PROT_READ, MAP_SHARED, fd_, 0);
+    if (ptr == MAP_FAILED) return false;
+    
+    mapped_ = static_cast<uint8_t*>(ptr);
+    mappedSize_ = fileSize_;
+    return true;
+}
+
+void RegionFile::unmapFile() {
+    if (mapped_) {
+        munmap(mapped_, mappedSize_);
+        mapped_ = nullptr;
+        mappedSize_ = 0;
+    }
+}
+
+bool RegionFile::read(int localX, int localZ, std::vector<uint8_t>& out) {
+    if (fd_ < 0) return false;
+    
+    const RegionEntry& entry = entries_[localZ * regionSize_ + localX];
+    if (entry.length == 0) return false;
+    if (!mapFile()) return false;
+    if (static_cast<size_t>(entry.offset) + entry.length > mappedSize_) return false;
+    
+    out.assign(mapped_ + entry.offset, mapped_ + entry.offset + entry.length);
+    return true;
+}
+
+bool RegionFile::write(int localX, int localZ, const uint8_t* data, size_t size) {
+    if (fd_ < 0 || size == 0) return false;
+    
+    int slot = localZ * regionSize_ + localX;
+    RegionEntry entry = entries_[slot];
+    
+    // Overwrite in place when the new payload fits, otherwise append
+    if (entry.length == 0 || size > entry.length) {
+        entry.offset = static_cast<uint32_t>(fileSize_);
+    }
+    entry.length = static_cast<uint32_t>(size);
+    
+    // The mapping may not observe pwrite (Emscripten copies on mmap), so drop it
+    unmapFile();
+    
+    if (pwrite(fd_, data, size, entry.offset) != static_cast<ssize_t>(size)) return false;
+    off_t entryOffset = sizeof(RegionHeader) + slot * sizeof(RegionEntry);
+    if (pwrite(fd_, &entry, sizeof(entry), entryOffset) != sizeof(entry)) return false;
+    
+    entries_[slot] = entry;
+    fileSize_ = std::max(fileSize_, static_cast<size_t>(entry.offset) + size);
+    return true;
+}
+
+// RegionStore implementation
+RegionStore::RegionStore(const std::string& directory, int regionSize, int maxOpenFiles)
+    : directory_(directory)
+    , regionSize_(regionSize)
+    , maxOpenFiles_(maxOpenFiles)
+{
+    mkdir(directory_.c_str(), 0755); // Fine if it already exists
+}
+
+RegionStore::~RegionStore() {
+    closeAll();
+}
+
+void RegionStore::closeAll() {
+    for (auto& pair : regions_) {
+        delete pair.second;
+    }
+    regions_.clear();
+}
+
+RegionFile* RegionStore::getRegion(int regionX, int regionZ) {
+    std::pair<int, int> key(regionX, regionZ);
+    auto it = regions_.find(key);
+    if (it != regions_.end()) return it->second;
+    
+    // Keep the number of open descriptors bounded
+    if (static_cast<int>(regions_.size()) >= maxOpenFiles_) {
+        delete regions_.begin()->second;
+        regions_.erase(regions_.begin());
+    }
+    
+    std::string path = directory_ + "/r." + std::to_string(regionX) + "." +
+                       std::to_string(regionZ) + ".dcr";
+    RegionFile* region = new RegionFile(path, regionSize_);
+    if (!region->isOpen()) {
+        delete region;
+        return nullptr;
+    }
+    
+    regions_[key] = region;
+    return region;
+}
+
+bool RegionStore::loadChunk(int chunkX, int chunkZ, std::vector<uint8_t>& out) {
+    int regionX = floorDiv(chunkX, regionSize_);
+    int regionZ = floorDiv(chunkZ, regionSize_);
+    
+    RegionFile* region = getRegion(regionX, regionZ);
+    if (!region) return false;
+    
+    return region->read(chunkX - regionX * regionSize_, chunkZ - regionZ * regionSize_, out);
+}
+
+bool RegionStore::saveChunk(int chunkX, int chunkZ, const std::vector<uint8_t>& data) {
+    int regionX = floorDiv(chunkX, regionSize_);
+    int regionZ = floorDiv(chunkZ, regionSize_);
+    
+    RegionFile* region = getRegion(regionX, regionZ);
+    if (!region) return false;
+    
+    return region->write(chunkX - regionX * regionSize_, chunkZ - regionZ * regionSize_,
+                         data.data(), data.size());
+}
@@ -1,8 +1,8 @@
 #include "renderer.h"
+#include "log.h"
 #include <cstring>
 #include <emscripten/emscripten.h>
 #include <emscripten/html5.h>
-#include <string>
 
 // Vertex shader source (GLSL ES 1.00 for better compatibility)
 const char* vertexShaderSource = R"(
@@ -71,27 +71,98 @@ void main() {
 }
 )";
 
+// Tilemap shader (GLSL ES 1.00): one quad, colours looked up per fragment
+const char* tilemapVertexShaderSource = R"(
+attribute vec3 aPosition;
+
+uniform mat4 uView;
+uniform mat4 uProjection;
+uniform float uTileSize;
+
+varying vec2 vTile;
+
+void main() {
+    gl_Position = uProjection * uView * vec4(aPosition, 1.0);
+    vTile = aPosition.xy / uTileSize + 0.5;
+}
+)";
+
+const char* tilemapFragmentShaderSource = R"(
+precision highp float;
+
+varying vec2 vTile;
+uniform vec2 uMapSize;
+uniform sampler2D uTileIds;
+uniform sampler2D uPalette;
+
+void main() {
+    vec2 tile = floor(vTile);
+    vec2 uv = vec2(mod(tile.x, uMapSize.x) + 0.5, tile.y + 0.5) / uMapSize;
+    float id = floor(texture2D(uTileIds, uv).r * 255.0 + 0.5);
+    vec4 color = texture2D(uPalette, vec2((id + 0.5) / 256.0, 0.5));
+    if (color.a == 0.0) discard;
+    
+    // Same shading as the front face of a batched cube
+    vec3 lightDir = normalize(vec3(0.5, 1.0, 0.3));
+    gl_FragColor = vec4(color.rgb * (0.6 + 0.4 * lightDir.z), color.a);
+}
+)";
+
+// Instanced cubes (GLSL ES 1.00 with per-instance attributes): the unit
+// cube is scaled and moved by aInstance (xyz centre, w edge length)
+const char* instanceVertexShaderSource = R"(
+attribute vec3 aPosition;
+attribute vec3 aNormal;
+attribute vec4 aColor;
+attribute vec4 aInstance;
+
+uniform mat4 uView;
+uniform mat4 uProjection;
+
+varying vec4 vColor;
+varying vec3 vNormal;
+
+void main() {
+    gl_Position = uProjection * uView * vec4(aPosition * aInstance.w + aInstance.xyz, 1.0);
+    vColor = aColor;
+    vNormal = aNormal;
+}
+)";
+
 Renderer::Renderer() 
-    : width_(0), height_(0), shaderProgram_(0), textureShaderProgram_(0),
-      vao_(0), vbo_(0), ebo_(0), texVao_(0), texVbo_(0), texEbo_(0),
-      batchIndexOffset_(0), texBatchIndexOffset_(0), currentBatchTexture_(0) {}
+    : width_(0), height_(0), shaderProgram_(0), textureShaderProgram_(0), tilemapShaderProgram_(0),
+      instanceShaderProgram_(0),
+      vao_(0), vbo_(0), ebo_(0), texVao_(0), texVbo_(0), texEbo_(0), tilemapVbo_(0),
+      instanceVao_(0), cubeVbo_(0), cubeEbo_(0), instanceVbo_(0),
+      batchIndexOffset_(0), texBatchIndexOffset_(0), currentBatchTexture_(0) {
+    float identity[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+    std::memcpy(viewMatrix_, identity, sizeof(identity));
+    std::memcpy(projMatrix_, identity, sizeof(identity));
+}
 
 Renderer::~Renderer() {
     if (shaderProgram_) glDeleteProgram(shaderProgram_);
     if (textureShaderProgram_) glDeleteProgram(textureShaderProgram_);
+    if (tilemapShaderProgram_) glDeleteProgram(tilemapShaderProgram_);
+    if (instanceShaderProgram_) glDeleteProgram(instanceShaderProgram_);
     if (vao_) glDeleteVertexArrays(1, &vao_);
     if (texVao_) glDeleteVertexArrays(1, &texVao_);
     if (vbo_) glDeleteBuffers(1, &vbo_);
     if (texVbo_) glDeleteBuffers(1, &texVbo_);
     if (ebo_) glDeleteBuffers(1, &ebo_);
     if (texEbo_) glDeleteBuffers(1, &texEbo_);
+    if (tilemapVbo_) glDeleteBuffers(1, &tilemapVbo_);
+    if (instanceVao_) glDeleteVertexArrays(1, &instanceVao_);
+    if (cubeVbo_) glDeleteBuffers(1, &cubeVbo_);
+    if (cubeEbo_) glDeleteBuffers(1, &cubeEbo_);
+    if (instanceVbo_) glDeleteBuffers(1, &instanceVbo_);
 }
 
 bool Renderer::initialize(int width, int height) {
     width_ = width;
     height_ = height;
     
-    emscripten_run_script("console.log('[C++] 🎨 Creating WebGL context...')");
+    DC_LOG_INFO("[C++] 🎨 Creating WebGL context...");
     
     // Verify canvas exists
     bool canvasExists = EM_ASM_INT({
@@ -105,7 +176,7 @@ bool Renderer::initialize(int width, int height) {
     });
     
     if (!canvasExists) {
-        emscripten_run_script("console.error('[C++] ❌ Canvas element not found in Module!')");
+        DC_LOG_ERROR("[C++] ❌ Canvas element not found in Module!");
         return false;
     }
     
@@ -122,24 +193,24 @@ bool Renderer::initialize(int width, int height) {
     // Use "#canvas" selector instead of 0/NULL
     EMSCRIPTEN_WEBGL_CONTEXT_HANDLE ctx = emscripten_webgl_create_context("#canvas", &attrs);
     if (ctx <= 0) {
-        emscripten_run_script(("console.error('[C++] ❌ Failed to create WebGL context! Error code: " + std::to_string(ctx) + "')").c_str());
+        DC_LOG_ERROR("[C++] ❌ Failed to create WebGL context! Error code: %d", static_cast<int>(ctx));
         return false;
     }
     
     EMSCRIPTEN_RESULT res = emscripten_webgl_make_context_current(ctx);
     if (res != EMSCRIPTEN_RESULT_SUCCESS) {
-        emscripten_run_script("console.error('[C++] ❌ Failed to make context current!')");
+        DC_LOG_ERROR("[C++] ❌ Failed to make context current!");
         return false;
     }
     
-    emscripten_run_script("console.log('[C++] ✅ WebGL context created successfully')");
+    DC_LOG_INFO("[C++] ✅ WebGL context created successfully");
     
     // Set viewport
     glViewport(0, 0, width, height);
-    emscripten_run_script(("console.log('[C++] 📐 Viewport set to " + std::to_string(width) + "x" + std::to_string(height) + "')").c_str());
+    DC_LOG_INFO("[C++] 📐 Viewport set to %dx%d", width, height);
     
     // Create shader program
-    emscripten_run_script("console.log('[C++] 🔨 Compiling shaders...')");
+    DC_LOG_INFO("[C++] 🔨 Compiling shaders...");
     createShaderProgram();
     
     // Generate buffers
@@ -150,11 +221,14 @@ bool Renderer::initialize(int width, int height) {
     glGenVertexArrays(1, &texVao_);
     glGenBuffers(1, &texVbo_);
     glGenBuffers(1, &texEbo_);
+    glGenBuffers(1, &tilemapVbo_);
     
-    emscripten_run_script("console.log('[C++] 📦 Buffers created')");
+    DC_LOG_INFO("[C++] 📦 Buffers created");
     
     // Create texture shader program
     createTextureShaderProgram();
+    createTilemapShaderProgram();
+    createInstanceShaderProgram();
     
     // Enable depth test and blending for textures
     glEnable(GL_DEPTH_TEST);
@@ -162,7 +236,7 @@ bool Renderer::initialize(int width, int height) {
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
-    emscripten_run_script("console.log('[C++] ✅ Renderer initialized successfully')");
+    DC_LOG_INFO("[C++] ✅ Renderer initialized successfully");
     
     return true;
 }
@@ -180,9 +254,9 @@ void Renderer::createShaderProgram() {
     GLint success;
     glGetProgramiv(shaderProgram_, GL_LINK_STATUS, &success);
     if (!success) {
-        emscripten_run_script("console.error('[C++] Shader program linking failed')");
+        DC_LOG_ERROR("[C++] Shader program linking failed");
     } else {
-        emscripten_run_script("console.log('[C++] ✅ Shader program linked successfully')");
+        DC_LOG_INFO("[C++] ✅ Shader program linked successfully");
     }
     
     glDeleteShader(vertShader);
@@ -203,10 +277,7 @@ GLuint Renderer::compileShader(GLenum type, const char* source) {
     GLint success;
     glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success) {
-        const char* shaderType = (type == GL_VERTEX_SHADER) ? "Vertex" : "Fragment";
-        emscripten_run_script(shaderType == "Vertex" ? 
-            "console.error('[C++] Vertex shader compilation failed')" :
-            "console.error('[C++] Fragment shader compilation failed')");
+        DC_LOG_ERROR("[C++] %s shader compilation failed", type == GL_VERTEX_SHADER ? "Vertex" : "Fragment");
     }
     
     return shader;
@@ -218,11 +289,13 @@ void Renderer::clear(const Color& color) {
 }
 
 void Renderer::setViewMatrix(const float* matrix) {
+    std::memcpy(viewMatrix_, matrix, sizeof(viewMatrix_));
     glUseProgram(shaderProgram_);
     glUniformMatrix4fv(viewMatrixLoc_, 1, GL_FALSE, matrix);
 }
 
 void Renderer::setProjectionMatrix(const float* matrix) {
+    std::memcpy(projMatrix_, matrix, sizeof(projMatrix_));
     glUseProgram(shaderProgram_);
     glUniformMatrix4fv(projMatrixLoc_, 1, GL_FALSE, matrix);
 }
@@ -413,9 +486,9 @@ void Renderer::createTextureShaderProgram() {
     GLint success;
     glGetProgramiv(textureShaderProgram_, GL_LINK_STATUS, &success);
     if (!success) {
-        emscripten_run_script("console.error('[C++] Texture shader program linking failed')");
+        DC_LOG_ERROR("[C++] Texture shader program linking failed");
     } else {
-        emscripten_run_script("console.log('[C++] ✅ Texture shader program linked')");
+        DC_LOG_INFO("[C++] ✅ Texture shader program linked");
     }
     
     glDeleteShader(vertShader);
@@ -439,7 +512,7 @@ GLuint Renderer::loadTexture(int width, int height, const unsigned char* data) {
     
     glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
     
-    emscripten_run_script(("console.log('[C++] 🖼️ Texture loaded: " + std::to_string(width) + "x" + std::to_string(height) + " ID=" + std::to_string(texture) + "')").c_str());
+    DC_LOG_DEBUG("[C++] 🖼️ Texture loaded: %dx%d ID=%u", width, height, texture);
     
     return texture;
 }
@@ -519,3 +592,192 @@ void Renderer::addTexturedQuadToBatch(const Vec3& position, const Vec3& size, GL
     
     texBatchIndexOffset_ += 4;
 }
+
+void Renderer::createTilemapShaderProgram() {
+    GLuint vertShader = compileShader(GL_VERTEX_SHADER, tilemapVertexShaderSource);
+    GLuint fragShader = compileShader(GL_FRAGMENT_SHADER, tilemapFragmentShaderSource);
+    
+    tilemapShaderProgram_ = glCreateProgram();
+    glAttachShader(tilemapShaderProgram_, vertShader);
+    glAttachShader(tilemapShaderProgram_, fragShader);
+    glBindAttribLocation(tilemapShaderProgram_, 0, "aPosition");
+    glLinkProgram(tilemapShaderProgram_);
+    
+    GLint success;
+    glGetProgramiv(tilemapShaderProgram_, GL_LINK_STATUS, &success);
+    if (!success) {
+        DC_LOG_ERROR("[C++] Tilemap shader program linking failed");
+    }
+    
+    glDeleteShader(vertShader);
+    glDeleteShader(fragShader);
+    
+    tileViewMatrixLoc_ = glGetUniformLocation(tilemapShaderProgram_, "uView");
+    tileProjMatrixLoc_ = glGetUniformLocation(tilemapShaderProgram_, "uProjection");
+    tileMapSizeLoc_ = glGetUniformLocation(tilemapShaderProgram_, "uMapSize");
+    tileSizeLoc_ = glGetUniformLocation(tilemapShaderProgram_, "uTileSize");
+    tileIdsLoc_ = glGetUniformLocation(tilemapShaderProgram_, "uTileIds");
+    tilePaletteLoc_ = glGetUniformLocation(tilemapShaderProgram_, "uPalette");
+}
+
+GLuint Renderer::createDataTexture(GLenum format, int width, int height, const unsigned char* data) {
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    
+    // Texels are looked up, never blended
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+    
+    return texture;
+}
+
+void Renderer::updateDataTexture(GLuint texture, GLenum format, int width, int height, const unsigned char* data) {
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+}
+
+void Renderer::drawTilemap(GLuint tileTexture, GLuint paletteTexture, int mapWidth, int mapHeight,
+                           int startColumn, int endColumn, float tileSize, float depth) {
+    if (endColumn <= startColumn) return;
+    
+    float half = tileSize * 0.5f;
+    float x0 = startColumn * tileSize - half;
+    float x1 = endColumn * tileSize - half;
+    float y0 = -half;
+    float y1 = mapHeight * tileSize - half;
+    
+    // Counter-clockwise when seen from +z, like the cube front faces
+    float vertices[] = {
+        x0, y0, depth,  x1, y0, depth,  x1, y1, depth,
+        x0, y0, depth,  x1, y1, depth,  x0, y1, depth
+    };
+    
+    glUseProgram(tilemapShaderProgram_);
+    glUniformMatrix4fv(tileViewMatrixLoc_, 1, GL_FALSE, viewMatrix_);
+    glUniformMatrix4fv(tileProjMatrixLoc_, 1, GL_FALSE, projMatrix_);
+    glUniform2f(tileMapSizeLoc_, (float)mapWidth, (float)mapHeight);
+    glUniform1f(tileSizeLoc_, tileSize);
+    glUniform1i(tileIdsLoc_, 0);
+    glUniform1i(tilePaletteLoc_, 1);
+    
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, tileTexture);
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, paletteTexture);
+    glActiveTexture(GL_TEXTURE0);
+    
+    glBindVertexArray(texVao_);
+    glBindBuffer(GL_ARRAY_BUFFER, tilemapVbo_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_DYNAMIC_DRAW);
+    
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glDisableVertexAttribArray(1);
+    
+    glDrawArrays(GL_TRIANGLES, 0, 6);
+}
+
+void Renderer::createInstanceShaderProgram() {
+    GLuint vertShader = compileShader(GL_VERTEX_SHADER, instanceVertexShaderSource);
+    GLuint fragShader = compileShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+    
+    instanceShaderProgram_ = glCreateProgram();
+    glAttachShader(instanceShaderProgram_, vertShader);
+    glAttachShader(instanceShaderProgram_, fragShader);
+    glBindAttribLocation(instanceShaderProgram_, 0, "aPosition");
+    glBindAttribLocation(instanceShaderProgram_, 1, "aNormal");
+    glBindAttribLocation(instanceShaderProgram_, 2, "aColor");
+    glBindAttribLocation(instanceShaderProgram_, 3, "aInstance");
+    glLinkProgram(instanceShaderProgram_);
+    
+    GLint success;
+    glGetProgramiv(instanceShaderProgram_, GL_LINK_STATUS, &success);
+    if (!success) {
+        DC_LOG_ERROR("[C++] Instance shader program linking failed");
+    }
+    
+    glDeleteShader(vertShader);
+    glDeleteShader(fragShader);
+    
+    instViewMatrixLoc_ = glGetUniformLocation(instanceShaderProgram_, "uView");
+    instProjMatrixLoc_ = glGetUniformLocation(instanceShaderProgram_, "uProjection");
+    
+    // Unit cube (edge 1, centred on the origin): position and normal per vertex
+    float cube[] = {
+        // Front
+        -0.5f, -0.5f, 0.5f, 0, 0, 1,   0.5f, -0.5f, 0.5f, 0, 0, 1,
+        0.5f, 0.5f, 0.5f, 0, 0, 1,     -0.5f, 0.5f, 0.5f, 0, 0, 1,
+        // Back
+        -0.5f, -0.5f, -0.5f, 0, 0, -1, 0.5f, -0.5f, -0.5f, 0, 0, -1,
+        0.5f, 0.5f, -0.5f, 0, 0, -1,   -0.5f, 0.5f, -0.5f, 0, 0, -1,
+        // Top
+        -0.5f, 0.5f, -0.5f, 0, 1, 0,   0.5f, 0.5f, -0.5f, 0, 1, 0,
+        0.5f, 0.5f, 0.5f, 0, 1, 0,     -0.5f, 0.5f, 0.5f, 0, 1, 0,
+        // Bottom
+        -0.5f, -0.5f, -0.5f, 0, -1, 0, 0.5f, -0.5f, -0.5f, 0, -1, 0,
+        0.5f, -0.5f, 0.5f, 0, -1, 0,   -0.5f, -0.5f, 0.5f, 0, -1, 0,
+        // Right
+        0.5f, -0.5f, -0.5f, 1, 0, 0,   0.5f, -0.5f, 0.5f, 1, 0, 0,
+        0.5f, 0.5f, 0.5f, 1, 0, 0,     0.5f, 0.5f, -0.5f, 1, 0, 0,
+        // Left
+        -0.5f, -0.5f, -0.5f, -1, 0, 0, -0.5f, -0.5f, 0.5f, -1, 0, 0,
+        -0.5f, 0.5f, 0.5f, -1, 0, 0,   -0.5f, 0.5f, -0.5f, -1, 0, 0,
+    };
+    unsigned short indices[] = {
+        0, 1, 2, 2, 3, 0,       // Front
+        6, 5, 4, 4, 7, 6,       // Back
+        8, 9, 10, 10, 11, 8,    // Top
+        14, 13, 12, 12, 15, 14, // Bottom
+        16, 17, 18, 18, 19, 16, // Right
+        22, 21, 20, 20, 23, 22  // Left
+    };
+    
+    glGenVertexArrays(1, &instanceVao_);
+    glGenBuffers(1, &cubeVbo_);
+    glGenBuffers(1, &cubeEbo_);
+    glGenBuffers(1, &instanceVbo_);
+    
+    glBindVertexArray(instanceVao_);
+    glBindBuffer(GL_ARRAY_BUFFER, cubeVbo_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(cube), cube, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+    glEnableVertexAttribArray(1);
+    
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, cubeEbo_);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    
+    // Colour and placement advance once per cube, not per vertex
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    glVertexAttribPointer(2, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)offsetof(CubeInstance, color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribDivisor(2, 1);
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(CubeInstance), (void*)offsetof(CubeInstance, position));
+    glEnableVertexAttribArray(3);
+    glVertexAttribDivisor(3, 1);
+    
+    glBindVertexArray(0);
+}
+
+void Renderer::drawCubeInstances(const CubeInstance* instances, int count) {
+    if (count <= 0) return;
+    
+    glUseProgram(instanceShaderProgram_);
+    glUniformMatrix4fv(instViewMatrixLoc_, 1, GL_FALSE, viewMatrix_);
+    glUniformMatrix4fv(instProjMatrixLoc_, 1, GL_FALSE, projMatrix_);
+    
+    glBindVertexArray(instanceVao_);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVbo_);
+    glBufferData(GL_ARRAY_BUFFER, count * sizeof(CubeInstance), instances, GL_STREAM_DRAW);
+    
+    glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_SHORT, 0, count);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,87 @@
+#include "spatial_hash.h"
+#include <cmath>
+
+SpatialHash::SpatialHash(float cellSize)
+    : cellSize_(cellSize)
+    , invCellSize_(1.0f / cellSize)
+{}
+
+void SpatialHash::clear() {
+    cells_.clear();
+    idCell_.clear();
+    idSlot_.clear();
+}
+
+void SpatialHash::addToCell(int id, uint64_t key) {
+    std::vector<int>& cell = cells_[key];
+    idCell_[id] = key;
+    idSlot_[id] = static_cast<int>(cell.size());
+    cell.push_back(id);
+}
+
+void SpatialHash::removeFromCell(int id) {
+    auto it = cells_.find(idCell_[id]);
+    if (it == cells_.end()) return;
+    
+    // Swap-and-pop inside the cell list
+    std::vector<int>& cell = it->second;
+    int slot = idSlot_[id];
+    int last = cell.back();
+    cell[slot] = last;
+    idSlot_[last] = slot;
+    cell.pop_back();
+    idSlot_[id] = -1;
+    
+    if (cell.empty()) {
+        cells_.erase(it);
+    }
+}
+
+void SpatialHash::insert(int id, float x, float z) {
+    if (id >= static_cast<int>(idCell_.size())) {
+        idCell_.resize(id + 1, 0);
+        idSlot_.resize(id + 1, -1);
+    }
+    if (idSlot_[id] >= 0) removeFromCell(id);
+    addToCell(id, cellKey(toCell(x), toCell(z)));
+}
+
+void SpatialHash::remove(int id) {
+    if (id < 0 || id >= static_cast<int>(idSlot_.size()) || idSlot_[id] < 0) return;
+    removeFromCell(id);
+}
+
+void SpatialHash::move(int id, float x, float z) {
+    uint64_t key = cellKey(toCell(x), toCell(z));
+    if (idSlot_[id] >= 0 && idCell_[id] == key) return;
+    
+    if (idSlot_[id] >= 0) removeFromCell(id);
+    addToCell(id, key);
+}
+
+void SpatialHash::rename(int oldId, int newId) {
+    if (oldId == newId || idSlot_[oldId] < 0) return;
+    if (newId >= static_cast<int>(idCell_.size())) {
+        idCell_.resize(newId + 1, 0);
+        idSlot_.resize(newId + 1, -1);
+    }
+    if (idSlot_[newId] >= 0) removeFromCell(newId);
+    
+    cells_[idCell_[oldId]][idSlot_[oldId]] = newId;
+    idCell_[newId] = idCell_[oldId];
+    idSlot_[newId] = idSlot_[oldId];
+    idSlot_[oldId] = -1;
+}
+
+void SpatialHash::query(float minX, float minZ, float maxX, float maxZ, std::vector<int>& out) const {
+    int cellMinX = toCell(minX), cellMaxX = toCell(maxX);
+    int cellMinZ = toCell(minZ), cellMaxZ = toCell(maxZ);
+    
+    for (int cz = cellMinZ; cz <= cellMaxZ; cz++) {
+        for (int cx = cellMinX; cx <= cellMaxX; cx++) {
+            auto it = cells_.find(cellKey(cx, cz));
+            if (it == cells_.end()) continue;
+            out.insert(out.end(), it->second.begin(), it->second.end());
+        }
+    }
+}
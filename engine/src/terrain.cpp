@@ -1,5 +1,6 @@
 #include "terrain.h"
 #include <cmath>
+#include <algorithm>
 
 VoxelTerrain::VoxelTerrain(int size, int maxHeight) 
     : size_(size), maxHeight_(maxHeight) {
@@ -16,6 +17,8 @@ float VoxelTerrain::noise(float x, float z) const {
 
 void VoxelTerrain::generate() {
     blocks_.clear();
+    occupancy_.assign((static_cast<size_t>(size_) * size_ * maxHeight_ + 63) / 64, 0);
+    columnHeights_.assign(size_ * size_, 0);
     
     int halfSize = size_ / 2;
     
@@ -38,6 +41,28 @@ void VoxelTerrain::addBlock(BlockType type, int x, int y, int z) {
     block.type = type;
     block.position = Vec3(static_cast<float>(x * 2), static_cast<float>(y * 2), static_cast<float>(z * 2));
     blocks_.push_back(block);
+    
+    int gx = x + size_ / 2;
+    int gz = z + size_ / 2;
+    if (type == BlockType::AIR || gx < 0 || gx >= size_ || gz < 0 || gz >= size_ || y < 0 || y >= maxHeight_) return;
+    
+    size_t bit = (static_cast<size_t>(y) * size_ + gz) * size_ + gx;
+    occupancy_[bit / 64] |= uint64_t(1) << (bit % 64);
+    columnHeights_[gz * size_ + gx] = std::max(columnHeights_[gz * size_ + gx], y + 1);
+}
+
+// Block b spans [2b - 1, 2b + 1] (cubes are centred on 2b)
+int VoxelTerrain::worldToCell(float v) const {
+    return static_cast<int>(std::floor((v + 1.0f) * 0.5f));
+}
+
+bool VoxelTerrain::isOccupied(int cellX, int cellY, int cellZ) const {
+    int gx = cellX + size_ / 2;
+    int gz = cellZ + size_ / 2;
+    if (gx < 0 || gx >= size_ || gz < 0 || gz >= size_ || cellY < 0 || cellY >= maxHeight_) return false;
+    
+    size_t bit = (static_cast<size_t>(cellY) * size_ + gz) * size_ + gx;
+    return (occupancy_[bit / 64] >> (bit % 64)) & 1;
 }
 
 Color VoxelTerrain::getBlockColor(BlockType type) const {
@@ -63,40 +88,120 @@ void VoxelTerrain::render(Renderer& renderer) {
 }
 
 float VoxelTerrain::getHeightAt(float x, float z) const {
-    int blockX = static_cast<int>(x / 2.0f);
-    int blockZ = static_cast<int>(z / 2.0f);
-    
-    float maxY = 0;
-    for (const auto& block : blocks_) {
-        int bx = static_cast<int>(block.position.x / 2.0f);
-        int bz = static_cast<int>(block.position.z / 2.0f);
-        
-        if (bx == blockX && bz == blockZ) {
-            maxY = std::max(maxY, block.position.y + 2.0f);
-        }
-    }
+    int gx = worldToCell(x) + size_ / 2;
+    int gz = worldToCell(z) + size_ / 2;
+    if (gx < 0 || gx >= size_ || gz < 0 || gz >= size_) return 0;
     
-    return maxY;
+    int height = columnHeights_[gz * size_ + gx];
+    return height * 2.0f; // Top of the highest block (y * 2 + 2)
 }
 
 bool VoxelTerrain::isColliding(const Vec3& position, float radius) const {
-    for (const auto& block : blocks_) {
-        if (block.type == BlockType::AIR) continue;
+    // Only the cells under the sphere's bounding box can touch it
+    int minX = worldToCell(position.x - radius), maxX = worldToCell(position.x + radius);
+    int minY = worldToCell(position.y - radius), maxY = worldToCell(position.y + radius);
+    int minZ = worldToCell(position.z - radius), maxZ = worldToCell(position.z + radius);
         
-        Vec3 blockMin = block.position - Vec3(1, 1, 1);
-        Vec3 blockMax = block.position + Vec3(1, 1, 1);
+    for (int y = minY; y <= maxY; y++) {
+        for (int z = minZ; z <= maxZ; z++) {
+            for (int x = minX; x <= maxX; x++) {
+                if (!isOccupied(x, y, z)) continue;
         
-        Vec3 closest = Vec3(
-            std::max(blockMin.x, std::min(position.x, blockMax.x)),
-            std::max(blockMin.y, std::min(position.y, blockMax.y)),
-            std::max(blockMin.z, std::min(position.z, blockMax.z))
-        );
+                Vec3 blockMin = Vec3(x * 2.0f - 1.0f, y * 2.0f - 1.0f, z * 2.0f - 1.0f);
+                Vec3 blockMax = Vec3(x * 2.0f + 1.0f, y * 2.0f + 1.0f, z * 2.0f + 1.0f);
         
-        Vec3 diff = position - closest;
-        if (diff.length() < radius) {
-            return true;
+                Vec3 closest = Vec3(
+                    std::max(blockMin.x, std::min(position.x, blockMax.x)),
+                    std::max(blockMin.y, std::min(position.y, blockMax.y)),
+                    std::max(blockMin.z, std::min(position.z, blockMax.z))
+                );
+                
+                Vec3 diff = position - closest;
+                if (diff.length() < radius) {
+                    return true;
+                }
+            }
         }
     }
     
     return false;
 }
+
+SweepResult VoxelTerrain::sweepAABB(const Vec3& center, const Vec3& halfExtents, const Vec3& delta) const {
+    SweepResult result = {false, 1.0f, Vec3(0, 0, 0)};
+    
+    // Broadphase: cells covered by the box at the start and end of the move
+    Vec3 end = center + delta;
+    int minX = worldToCell(std::min(center.x, end.x) - halfExtents.x);
+    int maxX = worldToCell(std::max(center.x, end.x) + halfExtents.x);
+    int minY = worldToCell(std::min(center.y, end.y) - halfExtents.y);
+    int maxY = worldToCell(std::max(center.y, end.y) + halfExtents.y);
+    int minZ = worldToCell(std::min(center.z, end.z) - halfExtents.z);
+    int maxZ = worldToCell(std::max(center.z, end.z) + halfExtents.z);
+    
+    float c[3] = {center.x, center.y, center.z};
+    float d[3] = {delta.x, delta.y, delta.z};
+    float h[3] = {halfExtents.x, halfExtents.y, halfExtents.z};
+    
+    for (int y = minY; y <= maxY; y++) {
+        for (int z = minZ; z <= maxZ; z++) {
+            for (int x = minX; x <= maxX; x++) {
+                if (!isOccupied(x, y, z)) continue;
+                
+                // Ray (center, delta) against the block grown by the box extents
+                int cell[3] = {x, y, z};
+                float tEnter = -INFINITY, tExit = INFINITY;
+                int enterAxis = -1;
+                bool miss = false;
+                
+                for (int a = 0; a < 3 && !miss; a++) {
+                    float lo = cell[a] * 2.0f - 1.0f - h[a];
+                    float hi = cell[a] * 2.0f + 1.0f + h[a];
+                    
+                    if (std::fabs(d[a]) < 0.000001f) {
+                        if (c[a] <= lo || c[a] >= hi) miss = true;
+                        continue;
+                    }
+                    
+                    float t0 = (lo - c[a]) / d[a];
+                    float t1 = (hi - c[a]) / d[a];
+                    if (t0 > t1) std::swap(t0, t1);
+                    if (t0 > tEnter) {
+                        tEnter = t0;
+                        enterAxis = a;
+                    }
+                    tExit = std::min(tExit, t1);
+                    if (tEnter >= tExit) miss = true;
+                }
+                if (miss || tExit <= 0.0f || tEnter > 1.0f) continue;
+                
+                float normal[3] = {0, 0, 0};
+                float time = std::max(0.0f, tEnter);
+                
+                if (tEnter > 0.0f && enterAxis >= 0) {
+                    normal[enterAxis] = d[enterAxis] > 0 ? -1.0f : 1.0f;
+                } else {
+                    // Already overlapping: push out along the shallowest axis
+                    float best = INFINITY;
+                    for (int a = 0; a < 3; a++) {
+                        float offset = c[a] - cell[a] * 2.0f;
+                        float depth = 1.0f + h[a] - std::fabs(offset);
+                        if (depth < best) {
+                            best = depth;
+                            normal[0] = normal[1] = normal[2] = 0;
+                            normal[a] = offset >= 0 ? 1.0f : -1.0f;
+                        }
+                    }
+                }
+                
+                if (!result.hit || time < result.time) {
+                    result.hit = true;
+                    result.time = time;
+                    result.normal = Vec3(normal[0], normal[1], normal[2]);
+                }
+            }
+        }
+    }
+    
+    return result;
+}
@@ -1,18 +1,54 @@
 #include "terrain_2d.h"
 #include <cmath>
 #include <cstdlib>
+#include <algorithm>
 
-Terrain2D::Terrain2D(int width, int height) 
-    : width_(width), height_(height), village_(nullptr) {
-    tiles_.resize(height);
-    for (int y = 0; y < height; y++) {
-        tiles_[y].resize(width);
+static const Tile TILE_PALETTE[] = {
+    {TileType::AIR,      Color(135, 206, 235), 0},             // SKY
+    {TileType::GROUND,   Color(34, 139, 34),   TILE_SOLID},    // GRASS
+    {TileType::GROUND,   Color(139, 69, 19),   TILE_SOLID},    // DIRT
+    {TileType::GROUND,   Color(128, 128, 128), TILE_SOLID},    // STONE
+    {TileType::PLATFORM, Color(101, 67, 33),   TILE_PLATFORM}, // PLATFORM
+    {TileType::OBSTACLE, Color(64, 64, 64),    TILE_SOLID},    // OBSTACLE
+    {TileType::LAVA,     Color(255, 69, 0),    0}              // LAVA
+};
+
+// Village occupies columns VILLAGE_START_X - 5 .. VILLAGE_START_X + 49
+static const int VILLAGE_START_X = 50;
+
+// xorshift32, one state per segment so generation order does not matter
+static uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+Terrain2D::Terrain2D(int width, int height, uint32_t seed)
+    : width_(width), height_(height), seed_(seed), tileTexture_(0), paletteTexture_(0),
+      tileTextureDirty_(true), village_(nullptr) {
+    segmentCount_ = std::max(4, (width + SEGMENT_WIDTH - 1) / SEGMENT_WIDTH);
+    width_ = segmentCount_ * SEGMENT_WIDTH;
+    
+    tiles_.assign(width_ * height_, static_cast<uint8_t>(TileId::SKY));
+    groundHeights_.assign(width_, 0);
+    segments_.assign(segmentCount_, -1);
+    for (int i = 0; i < static_cast<int>(TileId::COUNT); i++) {
+        tileFlags_[i] = TILE_PALETTE[i].flags;
     }
     village_ = new Village();
+    
+    // The village sits on the natural ground height, so it is known before
+    // any of its segments are generated
+    villageGroundY_ = naturalGroundHeight(VILLAGE_START_X) - 1;
+    village_->generate((float)VILLAGE_START_X * 2.0f, (float)villageGroundY_ * 2.0f, 5);
+    
     generate();
 }
 
 Terrain2D::~Terrain2D() {
+    if (tileTexture_) glDeleteTextures(1, &tileTexture_);
+    if (paletteTexture_) glDeleteTextures(1, &paletteTexture_);
     delete village_;
 }
 
@@ -23,129 +59,182 @@ float noise2D(float x, float y) {
 }
 
 void Terrain2D::generate() {
-    generateTerrain();
-    addPlatforms();
-    addObstacles();
-    addVillage();
+    std::fill(segments_.begin(), segments_.end(), -1);
+    update(0.0f);
 }
 
-void Terrain2D::generateTerrain() {
-    // Fill with air
-    for (int y = 0; y < height_; y++) {
-        for (int x = 0; x < width_; x++) {
-            tiles_[y][x].type = TileType::AIR;
-            tiles_[y][x].color = Color(135, 206, 235); // Sky blue
+void Terrain2D::update(float cameraX) {
+    int cameraTile = (int)(cameraX / 2.0f);
+    
+    // Keep the segment behind the render window resident, the rest of the
+    // ring is spent ahead of the camera
+    int firstSegment = std::max(0, (cameraTile - 20) / SEGMENT_WIDTH);
+    int visibleEnd = std::max(0, cameraTile + 40) / SEGMENT_WIDTH;
+    int lastSegment = firstSegment + segmentCount_ - 1;
+    
+    bool prefetched = false;
+    for (int segment = firstSegment; segment <= lastSegment; segment++) {
+        if (segments_[segment % segmentCount_] == segment) continue;
+        
+        // Visible segments are needed now, the ones ahead can wait a frame
+        if (segment > visibleEnd) {
+            if (prefetched) break;
+            prefetched = true;
         }
+        generateSegment(segment);
     }
+}
+
+int Terrain2D::naturalGroundHeight(int x) const {
+    float n = noise2D(x * 0.1f, 0) * 0.5f + noise2D(x * 0.05f, 100) * 0.5f;
+    return 8 + (int)(n * 4.0f); // Height 8-12
+}
+
+void Terrain2D::generateSegment(int segment) {
+    int slot = segment % segmentCount_;
+    int startX = segment * SEGMENT_WIDTH;
+    int endX = startX + SEGMENT_WIDTH;
+    
+    // Recycle the ring slot
+    for (int y = 0; y < height_; y++) {
+        std::fill(tiles_.begin() + y * width_ + slot * SEGMENT_WIDTH,
+                  tiles_.begin() + y * width_ + (slot + 1) * SEGMENT_WIDTH,
+                  static_cast<uint8_t>(TileId::SKY));
+    }
+    std::fill(groundHeights_.begin() + slot * SEGMENT_WIDTH,
+              groundHeights_.begin() + (slot + 1) * SEGMENT_WIDTH, 0);
+    segments_[slot] = segment;
+    
+    uint32_t rng = (seed_ ^ (static_cast<uint32_t>(segment) * 0x9E3779B9u)) | 1;
     
+    generateTerrain(startX, endX, rng);
+    addPlatforms(startX, endX, rng);
+    addObstacles(startX, endX, rng);
+    addVillage(startX, endX);
+}
+
+void Terrain2D::generateTerrain(int startX, int endX, uint32_t& rng) {
     // Generate ground with varying height
-    for (int x = 0; x < width_; x++) {
-        float n = noise2D(x * 0.1f, 0) * 0.5f + noise2D(x * 0.05f, 100) * 0.5f;
-        int groundHeight = 8 + (int)(n * 4.0f); // Height 8-12
+    for (int x = startX; x < endX; x++) {
+        int groundHeight = naturalGroundHeight(x);
         
         for (int y = 0; y < groundHeight; y++) {
             if (y == groundHeight - 1) {
                 // Grass top
-                setTile(x, y, TileType::GROUND, Color(34, 139, 34));
+                setTile(x, y, TileId::GRASS);
             } else if (y >= groundHeight - 4) {
                 // Dirt
-                setTile(x, y, TileType::GROUND, Color(139, 69, 19));
+                setTile(x, y, TileId::DIRT);
             } else {
                 // Stone
-                setTile(x, y, TileType::GROUND, Color(128, 128, 128));
+                setTile(x, y, TileId::STONE);
             }
         }
         
         // Add lava patches randomly
-        if (rand() % 20 == 0 && x > 10) {
-            int lavaWidth = 2 + rand() % 3;
-            for (int lx = 0; lx < lavaWidth && x + lx < width_; lx++) {
-                setTile(x + lx, 0, TileType::LAVA, Color(255, 69, 0));
-                setTile(x + lx, 1, TileType::LAVA, Color(255, 69, 0));
+        if (nextRandom(rng) % 20 == 0 && x > 10) {
+            int lavaWidth = 2 + nextRandom(rng) % 3;
+            for (int lx = 0; lx < lavaWidth && x + lx < endX; lx++) {
+                setTile(x + lx, 0, TileId::LAVA);
+                setTile(x + lx, 1, TileId::LAVA);
             }
         }
     }
 }
 
-void Terrain2D::addPlatforms() {
-    // Add floating platforms
-    for (int i = 0; i < 15; i++) {
-        int x = 10 + rand() % (width_ - 20);
-        int y = 12 + rand() % 8; // Height 12-20
-        int platformWidth = 3 + rand() % 5;
+void Terrain2D::addPlatforms(int startX, int endX, uint32_t& rng) {
+    // Add floating platforms, about two per segment
+    for (int i = 0; i < 2; i++) {
+        int x = startX + nextRandom(rng) % SEGMENT_WIDTH;
+        int y = 12 + nextRandom(rng) % 8; // Height 12-20
+        int platformWidth = 3 + nextRandom(rng) % 5;
+        if (x < 10) continue;
         
-        for (int px = 0; px < platformWidth && x + px < width_; px++) {
-            setTile(x + px, y, TileType::PLATFORM, Color(101, 67, 33)); // Brown platform
+        for (int px = 0; px < platformWidth && x + px < endX; px++) {
+            setTile(x + px, y, TileId::PLATFORM);
         }
     }
 }
 
-void Terrain2D::addVillage() {
-    // Place village around x=50-80
-    int villageStartX = 50;
-    int groundY = getGroundHeight(villageStartX);
+void Terrain2D::addVillage(int startX, int endX) {
+    int groundY = villageGroundY_;
     
     // Flatten ground for village (make platform)
-    for (int x = villageStartX - 5; x < villageStartX + 50; x++) {
-        if (x >= 0 && x < width_) {
-            // Clear space above ground
-            for (int y = groundY; y < height_; y++) {
-                setTile(x, y, TileType::AIR, Color(135, 206, 235));
-            }
-            // Set flat ground level
-            for (int y = 0; y < groundY; y++) {
-                if (y == groundY - 1) {
-                    setTile(x, y, TileType::GROUND, Color(34, 139, 34)); // Grass
-                } else if (y >= groundY - 4) {
-                    setTile(x, y, TileType::GROUND, Color(139, 69, 19)); // Dirt
-                } else {
-                    setTile(x, y, TileType::GROUND, Color(128, 128, 128)); // Stone
-                }
+    for (int x = std::max(startX, VILLAGE_START_X - 5); x < std::min(endX, VILLAGE_START_X + 50); x++) {
+        // Clear space above ground
+        for (int y = groundY; y < height_; y++) {
+            setTile(x, y, TileId::SKY);
+        }
+        // Set flat ground level
+        for (int y = 0; y < groundY; y++) {
+            if (y == groundY - 1) {
+                setTile(x, y, TileId::GRASS);
+            } else if (y >= groundY - 4) {
+                setTile(x, y, TileId::DIRT);
+            } else {
+                setTile(x, y, TileId::STONE);
             }
         }
     }
-    
-    // Generate village buildings
-    village_->generate((float)villageStartX * 2.0f, (float)groundY * 2.0f, 5);
 }
 
-void Terrain2D::addObstacles() {
-    // Add obstacles (spikes, pillars, etc)
-    for (int i = 0; i < 10; i++) {
-        int x = 5 + rand() % (width_ - 10);
+void Terrain2D::addObstacles(int startX, int endX, uint32_t& rng) {
+    // Add obstacles (spikes, pillars, etc), one or two per segment
+    int count = 1 + nextRandom(rng) % 2;
+    for (int i = 0; i < count; i++) {
+        int x = startX + nextRandom(rng) % (endX - startX);
         int groundY = getGroundHeight(x);
+        int pillarHeight = 2 + nextRandom(rng) % 4;
+        if (x < 5) continue;
         
         if (groundY > 0 && getTileType(x, groundY) != TileType::LAVA) {
             // Add pillar obstacle
-            int pillarHeight = 2 + rand() % 4;
             for (int py = 0; py < pillarHeight; py++) {
-                setTile(x, groundY + py, TileType::OBSTACLE, Color(64, 64, 64)); // Dark gray
+                setTile(x, groundY + py, TileId::OBSTACLE);
             }
         }
     }
 }
 
+void Terrain2D::uploadTilemap(Renderer& renderer) {
+    if (!paletteTexture_) {
+        // Palette colours are 0-255; alpha 0 marks tiles that are not drawn
+        unsigned char palette[256 * 4] = {};
+        for (int i = 0; i < static_cast<int>(TileId::COUNT); i++) {
+            const Tile& tile = TILE_PALETTE[i];
+            palette[i * 4 + 0] = (unsigned char)tile.color.r;
+            palette[i * 4 + 1] = (unsigned char)tile.color.g;
+            palette[i * 4 + 2] = (unsigned char)tile.color.b;
+            palette[i * 4 + 3] = tile.type == TileType::AIR ? 0 : 255;
+        }
+        paletteTexture_ = renderer.createDataTexture(GL_RGBA, 256, 1, palette);
+    }
+    
+    // The ring buffer is already laid out as the texture: slot columns, rows by y
+    if (!tileTexture_) {
+        tileTexture_ = renderer.createDataTexture(GL_LUMINANCE, width_, height_, tiles_.data());
+    } else if (tileTextureDirty_) {
+        renderer.updateDataTexture(tileTexture_, GL_LUMINANCE, width_, height_, tiles_.data());
+    }
+    tileTextureDirty_ = false;
+}
+
 void Terrain2D::render(Renderer& renderer, float cameraX) {
     int startX = (int)(cameraX / 2.0f) - 20;
     int endX = startX + 60;
     
     if (startX < 0) startX = 0;
-    if (endX > width_) endX = width_;
     
-    renderer.beginBatch();
+    // Draw only the loaded run of columns; other ring slots hold stale segments
+    while (startX < endX && !isColumnLoaded(startX)) startX++;
+    int loadedEndX = startX;
+    while (loadedEndX < endX && isColumnLoaded(loadedEndX)) loadedEndX++;
     
-    // Render terrain tiles
-    for (int x = startX; x < endX; x++) {
-        for (int y = 0; y < height_; y++) {
-            const Tile& tile = tiles_[y][x];
-            
-            if (tile.type != TileType::AIR) {
-                // Render as cube with 2D positioning
-                Vec3 pos((float)x * 2.0f, (float)y * 2.0f, 0);
-                renderer.addCubeToBatch(pos, Vec3(2.0f, 2.0f, 2.0f), tile.color);
-            }
-        }
-    }
+    // Render terrain tiles as one textured quad in front of the cube faces
+    uploadTilemap(renderer);
+    renderer.drawTilemap(tileTexture_, paletteTexture_, width_, height_, startX, loadedEndX, 2.0f, 1.0f);
+    
+    renderer.beginBatch();
     
     // Render village buildings
     if (village_) {
@@ -155,36 +244,45 @@ void Terrain2D::render(Renderer& renderer, float cameraX) {
     renderer.endBatch();
 }
 
-bool Terrain2D::isSolid(int x, int y) const {
-    if (x < 0 || x >= width_ || y < 0 || y >= height_) return false;
-    TileType type = tiles_[y][x].type;
-    return type == TileType::GROUND || type == TileType::OBSTACLE;
+int Terrain2D::getGroundHeight(int x) const {
+    if (!isColumnLoaded(x)) return 0;
+    return groundHeights_[x % width_];
 }
 
-bool Terrain2D::isPlatform(int x, int y) const {
-    if (x < 0 || x >= width_ || y < 0 || y >= height_) return false;
-    return tiles_[y][x].type == TileType::PLATFORM;
+void Terrain2D::getGroundHeights(int startX, int count, int* out) const {
+    for (int i = 0; i < count; i++) {
+        int x = startX + i;
+        out[i] = isColumnLoaded(x) ? groundHeights_[x % width_] : 0;
+    }
 }
 
-int Terrain2D::getGroundHeight(int x) const {
-    if (x < 0 || x >= width_) return 0;
-    
-    for (int y = height_ - 1; y >= 0; y--) {
-        if (isSolid(x, y)) {
-            return y;
-        }
-    }
-    return 0;
+TileId Terrain2D::getTile(int x, int y) const {
+    if (y < 0 || y >= height_ || !isColumnLoaded(x)) return TileId::SKY;
+    return static_cast<TileId>(tiles_[y * width_ + x % width_]);
+}
+
+const Tile& Terrain2D::getTileInfo(TileId id) {
+    return TILE_PALETTE[static_cast<int>(id)];
 }
 
 TileType Terrain2D::getTileType(int x, int y) const {
-    if (x < 0 || x >= width_ || y < 0 || y >= height_) return TileType::AIR;
-    return tiles_[y][x].type;
+    return getTileInfo(getTile(x, y)).type;
 }
 
-void Terrain2D::setTile(int x, int y, TileType type, const Color& color) {
-    if (x >= 0 && x < width_ && y >= 0 && y < height_) {
-        tiles_[y][x].type = type;
-        tiles_[y][x].color = color;
+void Terrain2D::setTile(int x, int y, TileId id) {
+    if (y >= 0 && y < height_ && isColumnLoaded(x)) {
+        int slot = x % width_;
+        tiles_[y * width_ + slot] = static_cast<uint8_t>(id);
+        tileTextureDirty_ = true;
+        
+        int& ground = groundHeights_[slot];
+        if (tileFlags_[static_cast<int>(id)] & TILE_SOLID) {
+            if (y > ground) ground = y;
+        } else if (y == ground) {
+            // Top of the column was removed, find the next solid tile below
+            while (ground > 0 && !isSolid(x, ground)) {
+                ground--;
+            }
+        }
     }
 }